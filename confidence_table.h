@@ -0,0 +1,134 @@
+#ifndef CONFIDENCE_TABLE_H
+#define CONFIDENCE_TABLE_H
+
+#include <QList>
+#include <QString>
+#include <QtGlobal>
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+// Per-character OCR confidences stored column by column: one contiguous
+// array per field instead of one struct (with its own QString) per
+// character. Statistics only walk the byte-sized confidence column, which the
+// compiler can vectorize, and no character needs a heap allocation of its own.
+class CharacterConfidenceTable {
+public:
+    void reserve(int count) {
+        codepoints.reserve(count);
+        confidences.reserve(count);
+        x.reserve(count);
+        y.reserve(count);
+        width.reserve(count);
+        height.reserve(count);
+        wordNum.reserve(count);
+        lineNum.reserve(count);
+        blockNum.reserve(count);
+    }
+
+    void append(uint codepoint, int confidence, int left, int top, int boxWidth, int boxHeight,
+                int block, int line, int word) {
+        codepoints.push_back(codepoint);
+        confidences.push_back(static_cast<uint8_t>(qBound(0, confidence, 100)));
+        x.push_back(left);
+        y.push_back(top);
+        width.push_back(boxWidth);
+        height.push_back(boxHeight);
+        blockNum.push_back(block);
+        lineNum.push_back(line);
+        wordNum.push_back(word);
+    }
+
+    int size() const {
+        return static_cast<int>(confidences.size());
+    }
+
+    bool isEmpty() const {
+        return confidences.empty();
+    }
+
+    QString character(int i) const {
+        return QString::fromUcs4(&codepoints[i], 1);
+    }
+
+    std::vector<uint> codepoints;
+    std::vector<uint8_t> confidences;       // 0..100
+    std::vector<int> x;
+    std::vector<int> y;
+    std::vector<int> width;
+    std::vector<int> height;
+    std::vector<int> blockNum;
+    std::vector<int> lineNum;
+    std::vector<int> wordNum;
+};
+
+// Summary of a confidence column, computed in one pass and shared by every
+// report that prints it. add() folds in further columns, so the same summary
+// can be kept for a whole corpus without keeping the columns.
+struct ConfidenceStatistics {
+    qint64 count = 0;
+    double mean = 0.0;
+    int min = 0;
+    int max = 0;
+    std::vector<qint64> histogram = std::vector<qint64>(101, 0);     // Values per confidence
+    QList<int> thresholds;
+    QList<qint64> belowThreshold;                                      // Values below each threshold
+
+    static ConfidenceStatistics compute(const std::vector<uint8_t>& confidences,
+                                        const QList<int>& thresholds = QList<int>() << 70) {
+        ConfidenceStatistics stats;
+        stats.thresholds = thresholds;
+        for (int i = 0; i < thresholds.size(); i++) {
+            stats.belowThreshold << 0;
+        }
+        stats.add(confidences);
+        return stats;
+    }
+
+    void add(const std::vector<uint8_t>& confidences) {
+        if (confidences.empty()) {
+            return;
+        }
+
+        // Plain reductions over contiguous bytes; these vectorize
+        const uint8_t* data = confidences.data();
+        const size_t n = confidences.size();
+        uint64_t total = std::accumulate(data, data + n, static_cast<uint64_t>(0));
+        int columnMin = *std::min_element(data, data + n);
+        int columnMax = *std::max_element(data, data + n);
+
+        min = count > 0 ? qMin(min, columnMin) : columnMin;
+        max = count > 0 ? qMax(max, columnMax) : columnMax;
+        mean = (mean * count + total) / (count + n);
+        count += n;
+
+        for (size_t i = 0; i < n; i++) {
+            histogram[data[i]]++;
+        }
+
+        for (int t = 0; t < thresholds.size(); t++) {
+            for (size_t i = 0; i < n; i++) {
+                belowThreshold[t] += data[i] < thresholds[t] ? 1 : 0;
+            }
+        }
+    }
+
+    // Smallest confidence such that at least percent% of characters are at or below it
+    int percentile(double percent) const {
+        if (count == 0) {
+            return 0;
+        }
+        long long wanted = static_cast<long long>(qBound(0.0, percent, 100.0) / 100.0 * count + 0.5);
+        long long seen = 0;
+        for (int value = 0; value <= 100; value++) {
+            seen += histogram[value];
+            if (seen >= qMax(1LL, wanted)) {
+                return value;
+            }
+        }
+        return 100;
+    }
+};
+
+#endif // CONFIDENCE_TABLE_H
@@ -0,0 +1,270 @@
+#ifndef CORPUS_ANALYTICS_H
+#define CORPUS_ANALYTICS_H
+
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPair>
+#include <QString>
+#include <QTextStream>
+#include <QtGlobal>
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <queue>
+#include <vector>
+#include "confidence_table.h"
+
+// What one recognized image contributes to the corpus analytics
+struct ImageAnalytics {
+    QString imagePath;
+    QString settings;                       // e.g. "rus+ukr, psm 6"
+    int width = 0;
+    int height = 0;
+    qint64 recognitionMs = 0;
+    std::vector<uint8_t> wordConfidences;
+    QList<QPair<QString, QString>> confusions;      // (recognized, runner-up) for uncertain symbols
+};
+
+// Corpus-wide OCR statistics, updated as each image finishes and written as
+// a text report. Only aggregates are kept, so memory does not grow with the
+// number of images:
+//  - word confidence histograms per language/PSM combination
+//  - the images with the lowest mean word confidence
+//  - symbol confusion candidates (recognized symbol and its runner-up from
+//    Tesseract's ChoiceIterator), the raw material for fine-tuning decisions
+//  - recognition throughput per image size bucket
+//
+// addImage() may be called from any worker thread.
+class CorpusAnalytics {
+public:
+    explicit CorpusAnalytics(const QString& reportPath, int worstImageCount = 25, int maxConfusionPairs = 5000)
+        : reportPath(reportPath), worstImageCount(worstImageCount), maxConfusionPairs(maxConfusionPairs),
+          imageCount(0), changed(false) {}
+
+    void addImage(const ImageAnalytics& image) {
+        QMutexLocker locker(&mutex);
+        imageCount++;
+        changed = true;
+
+        SettingsStats& settings = settingsStats[image.settings];
+        settings.images++;
+        settings.words.add(image.wordConfidences);
+
+        if (image.wordConfidences.empty()) {
+            settings.imagesWithoutText++;
+        } else {
+            uint64_t total = 0;
+            for (uint8_t confidence : image.wordConfidences) {
+                total += confidence;
+            }
+
+            // Max-heap on the mean keeps the lowest worstImageCount images
+            WorstImage worst;
+            worst.meanConfidence = static_cast<double>(total) / image.wordConfidences.size();
+            worst.words = static_cast<int>(image.wordConfidences.size());
+            worst.imagePath = image.imagePath;
+            worst.settings = image.settings;
+            worstImages.push(worst);
+            if (static_cast<int>(worstImages.size()) > worstImageCount) {
+                worstImages.pop();
+            }
+        }
+
+        for (const QPair<QString, QString>& confusion : image.confusions) {
+            QString key = confusion.first + "\t" + confusion.second;
+            auto it = confusionCounts.find(key);
+            if (it != confusionCounts.end()) {
+                it.value()++;
+            } else if (confusionCounts.size() < maxConfusionPairs) {
+                confusionCounts.insert(key, 1);
+            }
+        }
+
+        SizeBucket& bucket = sizeBuckets[sizeBucketFor(static_cast<qint64>(image.width) * image.height)];
+        bucket.images++;
+        bucket.pixels += static_cast<qint64>(image.width) * image.height;
+        bucket.recognitionMs += image.recognitionMs;
+    }
+
+    int imagesRecorded() const {
+        QMutexLocker locker(&mutex);
+        return imageCount;
+    }
+
+    QString getReportPath() const {
+        return reportPath;
+    }
+
+    // Rewrites the report if images were added since it was last written
+    bool saveReport() {
+        QMutexLocker locker(&mutex);
+        if (!changed) {
+            return true;
+        }
+
+        QFile file(reportPath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            qDebug() << "Could not create analytics report:" << reportPath;
+            std::cout << "ERROR: Could not create analytics report: " << reportPath.toStdString() << std::endl;
+            return false;
+        }
+
+        QTextStream out(&file);
+        out.setCodec("UTF-8");
+        writeReport(out);
+        file.close();
+
+        changed = false;
+        std::cout << "Corpus analytics for " << imageCount << " images saved to: "
+                  << reportPath.toStdString() << std::endl;
+        return true;
+    }
+
+private:
+    struct SettingsStats {
+        int images = 0;
+        int imagesWithoutText = 0;
+        ConfidenceStatistics words;
+    };
+
+    struct WorstImage {
+        double meanConfidence = 0.0;
+        int words = 0;
+        QString imagePath;
+        QString settings;
+
+        bool operator<(const WorstImage& other) const {
+            return meanConfidence < other.meanConfidence;
+        }
+    };
+
+    struct SizeBucket {
+        int images = 0;
+        qint64 pixels = 0;
+        qint64 recognitionMs = 0;
+    };
+
+    static int sizeBucketFor(qint64 pixels) {
+        int bucket = 0;
+        while (bucket + 1 < bucketCount() && pixels >= bucketLowerBound(bucket + 1)) {
+            bucket++;
+        }
+        return bucket;
+    }
+
+    static int bucketCount() {
+        return 6;
+    }
+
+    static qint64 bucketLowerBound(int bucket) {
+        static const qint64 bounds[] = {0, 100000, 500000, 2000000, 8000000, 32000000};
+        return bounds[bucket];
+    }
+
+    static QString bucketLabel(int bucket) {
+        double lower = bucketLowerBound(bucket) / 1e6;
+        if (bucket + 1 >= bucketCount()) {
+            return QString(">= %1 MP").arg(lower);
+        }
+        return QString("%1 - %2 MP").arg(lower).arg(bucketLowerBound(bucket + 1) / 1e6);
+    }
+
+    void writeReport(QTextStream& out) const {
+        out << "OCR Corpus Analytics\n";
+        out << "Generated: " << QDateTime::currentDateTime().toString() << "\n";
+        out << "Images analysed: " << imageCount << "\n";
+        out << QString("=").repeated(80) << "\n\n";
+
+        out << "WORD CONFIDENCE BY LANGUAGE / PSM\n";
+        out << QString("-").repeated(80) << "\n";
+        for (auto it = settingsStats.begin(); it != settingsStats.end(); ++it) {
+            const SettingsStats& settings = it.value();
+            const ConfidenceStatistics& words = settings.words;
+            out << it.key() << ": " << settings.images << " images, " << words.count << " words, "
+                << settings.imagesWithoutText << " without text\n";
+            if (words.count == 0) {
+                out << "\n";
+                continue;
+            }
+            out << "  Mean " << QString::number(words.mean, 'f', 1) << "%, median " << words.percentile(50)
+                << "%, 10th percentile " << words.percentile(10) << "%\n";
+
+            // 10-point bins; the last one also holds 100
+            for (int bin = 0; bin < 10; bin++) {
+                qint64 binCount = 0;
+                for (int value = bin * 10; value < (bin == 9 ? 101 : bin * 10 + 10); value++) {
+                    binCount += words.histogram[value];
+                }
+                double share = 100.0 * binCount / words.count;
+                out << "  " << QString("%1-%2%").arg(bin * 10).arg(bin == 9 ? 100 : bin * 10 + 9).leftJustified(9)
+                    << QString::number(binCount).rightJustified(9) << "  "
+                    << QString::number(share, 'f', 1).rightJustified(5) << "%  "
+                    << QString("#").repeated(static_cast<int>(share / 2 + 0.5)) << "\n";
+            }
+            out << "\n";
+        }
+
+        out << "\nWORST IMAGES (lowest mean word confidence)\n";
+        out << QString("-").repeated(80) << "\n";
+        std::priority_queue<WorstImage> heap = worstImages;
+        QList<WorstImage> worst;
+        while (!heap.empty()) {
+            worst.prepend(heap.top());
+            heap.pop();
+        }
+        for (const WorstImage& image : worst) {
+            out << QString::number(image.meanConfidence, 'f', 1).rightJustified(5) << "%  "
+                << QString("%1 words").arg(image.words).leftJustified(10) << "  "
+                << image.imagePath << "  [" << image.settings << "]\n";
+        }
+
+        out << "\nCONFUSION CANDIDATES (recognized -> runner-up, most frequent first)\n";
+        out << QString("-").repeated(80) << "\n";
+        QList<QPair<int, QString>> confusions;
+        for (auto it = confusionCounts.begin(); it != confusionCounts.end(); ++it) {
+            confusions << qMakePair(it.value(), it.key());
+        }
+        std::sort(confusions.begin(), confusions.end(), [](const QPair<int, QString>& a, const QPair<int, QString>& b) {
+            return a.first > b.first || (a.first == b.first && a.second < b.second);
+        });
+        for (int i = 0; i < confusions.size() && i < 100; i++) {
+            QStringList pair = confusions[i].second.split('\t');
+            out << QString("'%1' -> '%2'").arg(pair.value(0), pair.value(1)).leftJustified(16)
+                << QString::number(confusions[i].first).rightJustified(8) << "\n";
+        }
+        if (confusionCounts.size() >= maxConfusionPairs) {
+            out << "(only the first " << maxConfusionPairs << " distinct pairs are counted)\n";
+        }
+
+        out << "\nTHROUGHPUT BY IMAGE SIZE (per worker)\n";
+        out << QString("-").repeated(80) << "\n";
+        for (auto it = sizeBuckets.begin(); it != sizeBuckets.end(); ++it) {
+            const SizeBucket& bucket = it.value();
+            double seconds = bucket.recognitionMs / 1000.0;
+            out << bucketLabel(it.key()).leftJustified(16)
+                << QString::number(bucket.images).rightJustified(8) << " images  "
+                << QString::number(bucket.recognitionMs / qMax(1, bucket.images)).rightJustified(7) << " ms/image  "
+                << QString::number(seconds > 0 ? bucket.pixels / 1e6 / seconds : 0.0, 'f', 2).rightJustified(8)
+                << " MP/s\n";
+        }
+    }
+
+    QString reportPath;
+    int worstImageCount;
+    int maxConfusionPairs;
+    int imageCount;
+    bool changed;
+    QMap<QString, SettingsStats> settingsStats;
+    std::priority_queue<WorstImage> worstImages;
+    QHash<QString, int> confusionCounts;
+    QMap<int, SizeBucket> sizeBuckets;
+    mutable QMutex mutex;
+};
+
+#endif // CORPUS_ANALYTICS_H
@@ -0,0 +1,224 @@
+#ifndef ENGINE_POOL_H
+#define ENGINE_POOL_H
+
+#include <QDebug>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+#include <iostream>
+#include <string>
+#include <tesseract/baseapi.h>
+
+// Pool of Tesseract engines that all share the same tessdata path and language.
+// Engines are created lazily (up to maxEngines) the first time they are needed
+// and are handed out through an EngineLease, which puts the engine back into
+// the pool when it goes out of scope. Engines can also be bound to slots (see
+// acquireSlot); a pool hands out either slot engines or shared ones.
+//
+// Every engine holds its own deserialized model: the public Tesseract API
+// cannot share one between engines, so memory grows with the engine count.
+// Engines are therefore loaded LSTM-only by default, which skips the legacy
+// classifier tables bundled in the standard models; an empty tessdata path
+// means TESSDATA_PREFIX or Tesseract's built-in default.
+class TesseractEnginePool {
+public:
+    class EngineLease {
+    public:
+        EngineLease() : pool(nullptr), api(nullptr), slot(-1) {}
+        EngineLease(TesseractEnginePool* owner, tesseract::TessBaseAPI* engine, int slot = -1)
+            : pool(owner), api(engine), slot(slot) {}
+
+        EngineLease(EngineLease&& other) : pool(other.pool), api(other.api), slot(other.slot) {
+            other.pool = nullptr;
+            other.api = nullptr;
+        }
+
+        EngineLease& operator=(EngineLease&& other) {
+            if (this != &other) {
+                release();
+                pool = other.pool;
+                api = other.api;
+                slot = other.slot;
+                other.pool = nullptr;
+                other.api = nullptr;
+            }
+            return *this;
+        }
+
+        EngineLease(const EngineLease&) = delete;
+        EngineLease& operator=(const EngineLease&) = delete;
+
+        ~EngineLease() {
+            release();
+        }
+
+        tesseract::TessBaseAPI* engine() const {
+            return api;
+        }
+
+        explicit operator bool() const {
+            return api != nullptr;
+        }
+
+        void release() {
+            if (pool && api) {
+                pool->release(api, slot);
+            }
+            pool = nullptr;
+            api = nullptr;
+        }
+
+    private:
+        TesseractEnginePool* pool;
+        tesseract::TessBaseAPI* api;
+        int slot;
+    };
+
+    TesseractEnginePool(const QString& tessdataPath, const QString& language, int maxEngines = 1,
+                        tesseract::OcrEngineMode engineMode = tesseract::OEM_LSTM_ONLY)
+        : tessdataPath(tessdataPath), language(language), engineMode(engineMode),
+          maxEngines(qMax(1, maxEngines)), createdEngines(0),
+          slotEngines(this->maxEngines, nullptr), slotLeased(this->maxEngines, false) {}
+
+    ~TesseractEnginePool() {
+        // All leases must have been returned before the pool is destroyed
+        for (tesseract::TessBaseAPI* api : idleEngines) {
+            api->End();
+            delete api;
+        }
+        idleEngines.clear();
+        for (tesseract::TessBaseAPI* api : slotEngines) {
+            if (api) {
+                api->End();
+                delete api;
+            }
+        }
+    }
+
+    TesseractEnginePool(const TesseractEnginePool&) = delete;
+    TesseractEnginePool& operator=(const TesseractEnginePool&) = delete;
+
+    // Blocks until an engine is available. Returns an empty lease if a new
+    // engine had to be created and its initialization failed.
+    EngineLease acquire(int pageSegmentationMode) {
+        QMutexLocker locker(&mutex);
+
+        while (idleEngines.isEmpty() && createdEngines >= maxEngines) {
+            available.wait(&mutex);
+        }
+
+        tesseract::TessBaseAPI* api = nullptr;
+        if (!idleEngines.isEmpty()) {
+            api = idleEngines.takeLast();
+        } else {
+            // Reserve the slot, then initialize without holding the lock
+            createdEngines++;
+            locker.unlock();
+            api = createEngine();
+            locker.relock();
+
+            if (!api) {
+                createdEngines--;
+                available.wakeOne();
+                return EngineLease();
+            }
+        }
+
+        api->SetPageSegMode(static_cast<tesseract::PageSegMode>(pageSegmentationMode));
+        return EngineLease(this, api);
+    }
+
+    // The engine bound to slot (0 .. maxEngines - 1), e.g. one slot per pinned
+    // worker. The first thread to acquire a slot creates its engine, so the
+    // engine's memory is allocated on that thread's NUMA node, and the engine
+    // is only ever handed out for the same slot again. Blocks while the slot's
+    // engine is leased; returns an empty lease if its initialization failed.
+    EngineLease acquireSlot(int pageSegmentationMode, int slot) {
+        QMutexLocker locker(&mutex);
+
+        while (slotLeased[slot]) {
+            available.wait(&mutex);
+        }
+        slotLeased[slot] = true;
+
+        tesseract::TessBaseAPI* api = slotEngines[slot];
+        if (!api) {
+            locker.unlock();
+            api = createEngine();
+            locker.relock();
+
+            if (!api) {
+                slotLeased[slot] = false;
+                available.wakeAll();
+                return EngineLease();
+            }
+            slotEngines[slot] = api;
+            createdEngines++;
+        }
+
+        api->SetPageSegMode(static_cast<tesseract::PageSegMode>(pageSegmentationMode));
+        return EngineLease(this, api, slot);
+    }
+
+    QString getLanguage() const {
+        return language;
+    }
+
+    int getMaxEngines() const {
+        return maxEngines;
+    }
+
+private:
+    tesseract::TessBaseAPI* createEngine() {
+        tesseract::TessBaseAPI* api = new tesseract::TessBaseAPI();
+        std::string path = tessdataPath.toStdString();
+        const char* datapath = tessdataPath.isEmpty() ? nullptr : path.c_str();
+        std::string languages = language.toStdString();
+
+        int result = api->Init(datapath, languages.c_str(), engineMode);
+        if (result != 0 && engineMode == tesseract::OEM_LSTM_ONLY) {
+            // Legacy-only models have no LSTM component; let Tesseract decide
+            qDebug() << "LSTM-only initialization failed, retrying with default engine mode for:" << language;
+            result = api->Init(datapath, languages.c_str(), tesseract::OEM_DEFAULT);
+        }
+        if (result != 0) {
+            qDebug() << "Could not initialize pooled tesseract engine with language:" << language;
+            std::cout << "ERROR: Could not initialize pooled tesseract engine with language: "
+                      << language.toStdString() << std::endl;
+            delete api;
+            return nullptr;
+        }
+        return api;
+    }
+
+    void release(tesseract::TessBaseAPI* api, int slot) {
+        // Drop the previous image and results so the next user starts clean
+        api->Clear();
+
+        QMutexLocker locker(&mutex);
+        if (slot >= 0) {
+            // Whoever waits may be waiting for another slot
+            slotLeased[slot] = false;
+            available.wakeAll();
+            return;
+        }
+        idleEngines.append(api);
+        available.wakeOne();
+    }
+
+    QString tessdataPath;
+    QString language;
+    tesseract::OcrEngineMode engineMode;
+    int maxEngines;
+    int createdEngines;
+    QList<tesseract::TessBaseAPI*> idleEngines;
+    QVector<tesseract::TessBaseAPI*> slotEngines;   // Null until the slot is first acquired
+    QVector<bool> slotLeased;
+    QMutex mutex;
+    QWaitCondition available;
+};
+
+#endif // ENGINE_POOL_H
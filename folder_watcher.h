@@ -0,0 +1,216 @@
+#ifndef FOLDER_WATCHER_H
+#define FOLDER_WATCHER_H
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QtGlobal>
+#include <algorithm>
+#include <iostream>
+
+#ifdef Q_OS_LINUX
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Reports image files that appear in a folder once whoever writes them is
+// done. On Linux this uses inotify: a file becomes a candidate when it is
+// closed after writing (IN_CLOSE_WRITE) or renamed into the folder
+// (IN_MOVED_TO), and is reported once settleMs passed without it being
+// written again. Elsewhere the folder listing is polled and a file is
+// reported once its size and modification time stayed the same for settleMs.
+//
+// Files already in the folder when watching starts are not reported, and a
+// file is reported again when it is rewritten.
+class FolderWatcher {
+public:
+    FolderWatcher(const QString& folderPath, const QStringList& nameFilters, int settleMs = 500)
+        : folderPath(folderPath), nameFilters(nameFilters), settleMs(qMax(0, settleMs)),
+          inotifyFd(-1), pollIntervalMs(1000) {}
+
+    ~FolderWatcher() {
+#ifdef Q_OS_LINUX
+        if (inotifyFd >= 0) {
+            close(inotifyFd);
+        }
+#endif
+    }
+
+    bool start() {
+        clock.start();
+#ifdef Q_OS_LINUX
+        inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotifyFd >= 0) {
+            QByteArray path = QFile::encodeName(folderPath);
+            uint32_t events = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MODIFY | IN_DELETE | IN_MOVED_FROM;
+            if (inotify_add_watch(inotifyFd, path.constData(), events) >= 0) {
+                std::cout << "Watching folder with inotify: " << folderPath.toStdString() << std::endl;
+                return true;
+            }
+            close(inotifyFd);
+            inotifyFd = -1;
+        }
+        qDebug() << "inotify unavailable, polling folder:" << folderPath;
+#endif
+        if (!QDir(folderPath).exists()) {
+            std::cout << "ERROR: Cannot watch missing folder: " << folderPath.toStdString() << std::endl;
+            return false;
+        }
+
+        // Only files that change after this point are reported
+        for (const QFileInfo& info : QDir(folderPath).entryInfoList(nameFilters, QDir::Files)) {
+            polledFiles[info.fileName()] = PolledFile{info.size(), info.lastModified(), -1};
+        }
+        std::cout << "Watching folder by polling every " << pollIntervalMs << " ms: "
+                  << folderPath.toStdString() << std::endl;
+        return true;
+    }
+
+    // Waits up to timeoutMs for files to settle and returns their names
+    // (relative to the folder) in the order they were completed
+    QStringList waitForFiles(int timeoutMs) {
+        QElapsedTimer timer;
+        timer.start();
+
+        while (true) {
+            QStringList settled = takeSettled();
+            qint64 remaining = timeoutMs - timer.elapsed();
+            if (!settled.isEmpty() || remaining <= 0) {
+                return settled;
+            }
+
+            // Wake up in time for the next pending file to settle
+            qint64 wait = remaining;
+            for (qint64 lastWrite : pending) {
+                wait = qMin(wait, qMax<qint64>(1, lastWrite + settleMs - clock.elapsed()));
+            }
+
+#ifdef Q_OS_LINUX
+            if (inotifyFd >= 0) {
+                pollfd fd = {inotifyFd, POLLIN, 0};
+                if (poll(&fd, 1, static_cast<int>(wait)) > 0) {
+                    readEvents();
+                }
+                continue;
+            }
+#endif
+            QThread::msleep(static_cast<unsigned long>(qMin<qint64>(wait, pollIntervalMs)));
+            pollFolder();
+        }
+    }
+
+private:
+    struct PolledFile {
+        qint64 size;
+        QDateTime modified;
+        qint64 lastChange;      // clock time of the last change, -1 = reported or pre-existing
+    };
+
+#ifdef Q_OS_LINUX
+    void readEvents() {
+        alignas(inotify_event) char buffer[16384];
+        while (true) {
+            ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+            if (length <= 0) {
+                return;
+            }
+
+            for (char* pointer = buffer; pointer < buffer + length;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(pointer);
+                pointer += sizeof(inotify_event) + event->len;
+
+                if (event->mask & IN_Q_OVERFLOW) {
+                    std::cout << "WARNING: inotify queue overflowed, some new files may be missed in: "
+                              << folderPath.toStdString() << std::endl;
+                    continue;
+                }
+                if (event->len == 0 || (event->mask & IN_ISDIR)) {
+                    continue;
+                }
+
+                QString name = QFile::decodeName(event->name);
+                if (!QDir::match(nameFilters, name)) {
+                    continue;
+                }
+
+                if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                    pending[name] = clock.elapsed();
+                } else if (event->mask & (IN_MODIFY | IN_DELETE | IN_MOVED_FROM)) {
+                    // Written again or gone: wait for the next close (if any)
+                    pending.remove(name);
+                }
+            }
+        }
+    }
+#endif
+
+    void pollFolder() {
+        QMap<QString, PolledFile> current;
+        for (const QFileInfo& info : QDir(folderPath).entryInfoList(nameFilters, QDir::Files)) {
+            PolledFile file{info.size(), info.lastModified(), clock.elapsed()};
+            if (polledFiles.contains(info.fileName())) {
+                const PolledFile& previous = polledFiles[info.fileName()];
+                if (previous.size == file.size && previous.modified == file.modified) {
+                    file.lastChange = previous.lastChange;
+                }
+            }
+            current[info.fileName()] = file;
+
+            if (file.lastChange >= 0) {
+                pending[info.fileName()] = file.lastChange;
+            } else {
+                pending.remove(info.fileName());
+            }
+        }
+        for (const QString& name : pending.keys()) {
+            if (!current.contains(name)) {
+                pending.remove(name);
+            }
+        }
+        polledFiles = current;
+    }
+
+    QStringList takeSettled() {
+        QList<QPair<qint64, QString>> settled;
+        qint64 now = clock.elapsed();
+        for (auto it = pending.begin(); it != pending.end();) {
+            if (now - it.value() >= settleMs) {
+                settled << qMakePair(it.value(), it.key());
+                if (polledFiles.contains(it.key())) {
+                    polledFiles[it.key()].lastChange = -1;
+                }
+                it = pending.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        std::sort(settled.begin(), settled.end());
+
+        QStringList names;
+        for (const QPair<qint64, QString>& file : settled) {
+            names << file.second;
+        }
+        return names;
+    }
+
+    QString folderPath;
+    QStringList nameFilters;
+    int settleMs;
+    int inotifyFd;
+    int pollIntervalMs;
+    QElapsedTimer clock;
+    QMap<QString, qint64> pending;              // File name -> clock time of its last completed write
+    QMap<QString, PolledFile> polledFiles;
+};
+
+#endif // FOLDER_WATCHER_H
@@ -0,0 +1,560 @@
+#ifndef IMAGE_PIPELINE_H
+#define IMAGE_PIPELINE_H
+
+#include <QByteArray>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include <tesseract/baseapi.h>
+#include <tesseract/ocrclass.h>
+#include <tesseract/resultiterator.h>
+#include "engine_pool.h"
+#include "line_refiner.h"
+#include "recognition_deadline.h"
+#include "onnx_text_detector.h"
+#include "ocr_recognizer.h"
+#include "result_cache.h"
+#include "near_duplicate_index.h"
+#include "corpus_analytics.h"
+
+// One recognized word with its box in image pixels
+struct OcrWord {
+    QString text;
+    float confidence = 0.0f;
+    cv::Rect box;
+    int line = 0;               // Text line index on the page, from 0
+};
+
+// What happened to one image in OcrImagePipeline::recognize
+struct ImageRecognition {
+    enum Status {
+        Recognized,             // text may still be empty: no text, or below minConfidence
+        Unreadable,             // Could not be decoded
+        Failed,
+        TimedOut,
+        Cancelled
+    };
+
+    Status status = Failed;
+    QString text;
+    int confidence = -1;        // Mean confidence; -1 for results reused from the cache or a near-duplicate
+
+    bool abandoned() const {
+        return status == TimedOut || status == Cancelled;
+    }
+};
+
+// The per-image recognition pipeline shared by TesseractOCR and OcrService:
+// result cache, decoding, near-duplicate reuse, the optional ONNX text
+// detector and line recognizer, page recognition under one deadline,
+// low-confidence line refinement and corpus analytics. The caller supplies
+// the engine; recognize() may run on several engines at once, but the
+// setters must not be called while it does.
+class OcrImagePipeline {
+public:
+    // cancelFlag (not owned, may be null) abandons every image while set
+    explicit OcrImagePipeline(const std::atomic<bool>* cancelFlag)
+        : cancelFlag(cancelFlag), engineMode(tesseract::OEM_LSTM_ONLY), pageSegMode(6),
+          refineLowConfidence(true), recognizerBackend("tesseract"), imageTimeoutMs(0),
+          resultCache(nullptr), corpusAnalytics(nullptr) {}
+
+    OcrImagePipeline(const OcrImagePipeline&) = delete;
+    OcrImagePipeline& operator=(const OcrImagePipeline&) = delete;
+
+    // Model the engines were created from; part of the cache key
+    void setModel(const QString& tessdataPath, tesseract::OcrEngineMode engineMode) {
+        this->tessdataPath = tessdataPath;
+        this->engineMode = engineMode;
+    }
+
+    // Language and page segmentation mode of the engines passed to recognize()
+    void setPageSettings(const QString& language, int pageSegmentationMode) {
+        this->language = language;
+        pageSegMode = pageSegmentationMode;
+    }
+
+    void setRefineLowConfidenceLines(bool enabled) {
+        refineLowConfidence = enabled;
+    }
+
+    // Abandons any single image after msecs (0 = no limit); see TesseractOCR::setImageTimeout
+    void setImageTimeout(int msecs) {
+        imageTimeoutMs = qMax(0, msecs);
+    }
+
+    int getImageTimeout() const {
+        return imageTimeoutMs;
+    }
+
+    // Results for byte-identical images are taken from this cache (not owned; nullptr disables)
+    void setResultCache(OcrResultCache* cache) {
+        resultCache = cache;
+    }
+
+    OcrResultCache* getResultCache() const {
+        return resultCache;
+    }
+
+    // Adds every page recognized on an engine to analytics (not owned; nullptr = off)
+    void setCorpusAnalytics(CorpusAnalytics* analytics) {
+        corpusAnalytics = analytics;
+    }
+
+    CorpusAnalytics* getCorpusAnalytics() const {
+        return corpusAnalytics;
+    }
+
+    // Reuses the result of an earlier image whose perceptual hash ("dhash" or
+    // "phash") differs in at most maxDistance bits; a negative distance turns
+    // this off. With recordMatches, matches are kept for takeMatches().
+    void setNearDuplicateDetection(int maxDistance, const QString& hashType = "dhash", bool recordMatches = true) {
+        if (maxDistance < 0) {
+            nearDuplicates.reset();
+            return;
+        }
+
+        NearDuplicateIndex::HashType type = hashType == "phash" ? NearDuplicateIndex::PHash : NearDuplicateIndex::DHash;
+        if (!nearDuplicates || nearDuplicates->getMaxDistance() != maxDistance || nearDuplicates->getHashType() != type) {
+            nearDuplicates.reset(new NearDuplicateIndex(maxDistance, type));
+        }
+        nearDuplicates->setRecordMatches(recordMatches);
+    }
+
+    // nullptr when near-duplicate detection is off
+    NearDuplicateIndex* getNearDuplicateIndex() const {
+        return nearDuplicates.get();
+    }
+
+    // Optional ONNX text detector; when loaded, only the detected regions are
+    // sent to the line recognizer and page layout analysis is skipped. An
+    // empty path removes the detector.
+    bool setTextDetectorModel(const QString& modelPath, int intraOpThreads = 1) {
+        if (modelPath.isEmpty()) {
+            textDetector.reset();
+            textDetectorModelPath.clear();
+            return true;
+        }
+        if (textDetector && modelPath == textDetectorModelPath) {
+            return true;
+        }
+
+        std::unique_ptr<OnnxTextDetector> detector(new OnnxTextDetector());
+        if (!detector->load(modelPath, intraOpThreads)) {
+            return false;
+        }
+        textDetector = std::move(detector);
+        textDetectorModelPath = modelPath;
+        return true;
+    }
+
+    // Optional CRNN/SVTR line recognizer; selected with setRecognizerBackend("onnx")
+    bool setOnnxLineRecognizer(const QString& modelPath, const QString& dictionaryPath,
+                               int intraOpThreads = 1, int batchSize = 16) {
+        if (onnxLineRecognizer && modelPath == recognizerModelPath) {
+            onnxLineRecognizer->setBatchSize(batchSize);
+            return true;
+        }
+
+        std::unique_ptr<OnnxLineRecognizer> recognizer(new OnnxLineRecognizer());
+        if (!recognizer->load(modelPath, dictionaryPath, intraOpThreads)) {
+            return false;
+        }
+        recognizer->setBatchSize(batchSize);
+        onnxLineRecognizer = std::move(recognizer);
+        recognizerModelPath = modelPath;
+        return true;
+    }
+
+    // "tesseract" or "onnx"; used for detected regions and single-line images
+    bool setRecognizerBackend(const QString& backend) {
+        if (backend == "onnx" && !onnxLineRecognizer) {
+            qDebug() << "ONNX line recognizer not loaded, keeping backend:" << recognizerBackend;
+            std::cout << "ERROR: ONNX line recognizer not loaded, keeping backend: "
+                      << recognizerBackend.toStdString() << std::endl;
+            return false;
+        }
+        if (backend != "onnx" && backend != "tesseract") {
+            qDebug() << "Unknown recognizer backend:" << backend;
+            std::cout << "ERROR: Unknown recognizer backend: " << backend.toStdString() << std::endl;
+            return false;
+        }
+        recognizerBackend = backend;
+        return true;
+    }
+
+    // Engines for the Tesseract line backend (not owned; nullptr removes it)
+    void setLineEnginePool(TesseractEnginePool* pool) {
+        tesseractLineRecognizer.reset(pool ? new TesseractLineRecognizer(pool) : nullptr);
+    }
+
+    // The selected line recognizer; nullptr until a line engine pool is set
+    // for the Tesseract backend
+    OcrRecognizer* lineRecognizer() const {
+        if (recognizerBackend == "onnx" && onnxLineRecognizer) {
+            return onnxLineRecognizer.get();
+        }
+        return tesseractLineRecognizer.get();
+    }
+
+    // Settings that change the text produced for an image; part of the cache key.
+    // tessdataPath is the one every engine is created from, so models like
+    // tessdata_best and tessdata_fast never share results.
+    QString resultSettings(const QString& language, int psm, bool useConfidence, int minConfidence) const {
+        return QStringList({tessdataPath, language, QString::number(psm), QString::number(engineMode),
+                            useConfidence ? QString::number(minConfidence) : QString("-"),
+                            refineLowConfidence ? "refine" : "-", textDetectorModelPath,
+                            recognizerBackend, recognizerModelPath}).join("|");
+    }
+
+    static bool readImageFile(const QString& imagePath, QByteArray& imageBytes) {
+        QFile imageFile(imagePath);
+        if (!imageFile.open(QIODevice::ReadOnly)) {
+            qDebug() << "Could not load image:" << imagePath;
+            std::cout << "ERROR: Could not load image: " << imagePath.toStdString() << std::endl;
+            return false;
+        }
+        imageBytes = imageFile.readAll();
+        imageFile.close();
+        return true;
+    }
+
+    // Recognizes one encoded image (PNG, JPEG, ...) on engine; imagePath names
+    // it in the log and the reports. With useConfidence, results below
+    // minConfidence (after line refinement) come back empty. words
+    // (optional) receives the words of the page as first recognized, or one
+    // entry per detected region; it stays empty for reused results.
+    ImageRecognition recognize(tesseract::TessBaseAPI* engine, const QString& imagePath, QByteArray imageBytes,
+                               bool useConfidence, int minConfidence, std::vector<OcrWord>* words = nullptr) {
+        ImageRecognition recognition;
+
+        QString settings = resultSettings(language, pageSegMode, useConfidence, minConfidence);
+        QByteArray cacheKey;
+        if (resultCache) {
+            cacheKey = OcrResultCache::makeKey(imageBytes, settings);
+            if (resultCache->lookup(cacheKey, recognition.text)) {
+                std::cout << "Using cached result for identical image: " << imagePath.toStdString() << std::endl;
+                recognition.status = ImageRecognition::Recognized;
+                return recognition;
+            }
+        }
+
+        // Decode image using OpenCV
+        cv::Mat image = cv::imdecode(cv::Mat(1, imageBytes.size(), CV_8U, imageBytes.data()), cv::IMREAD_COLOR);
+        if (image.empty()) {
+            qDebug() << "Could not load image:" << imagePath;
+            std::cout << "ERROR: Could not load image: " << imagePath.toStdString() << std::endl;
+            recognition.status = ImageRecognition::Unreadable;
+            return recognition;
+        }
+
+        std::cout << "Successfully loaded image: " << imagePath.toStdString() << std::endl;
+
+        quint64 imageHash = 0;
+        if (nearDuplicates) {
+            imageHash = nearDuplicates->hash(image);
+            if (nearDuplicates->lookup(imageHash, settings, imagePath, recognition.text)) {
+                // Not cached: the cache key is this image's exact content, and
+                // the text belongs to another image
+                std::cout << "Reusing result of near-duplicate image for: " << imagePath.toStdString() << std::endl;
+                recognition.status = ImageRecognition::Recognized;
+                return recognition;
+            }
+        }
+
+        recognition = recognizeLoadedImage(engine, imagePath, image, useConfidence, minConfidence, words);
+        if (recognition.status != ImageRecognition::Recognized) {
+            // Not cached: a later run with a longer timeout should try again
+            return recognition;
+        }
+        if (resultCache) {
+            resultCache->insert(cacheKey, recognition.text);
+        }
+        if (nearDuplicates) {
+            nearDuplicates->insert(imageHash, settings, imagePath, recognition.text);
+        }
+        return recognition;
+    }
+
+    void reportAbandoned(const QString& imagePath, int timeoutMs) const {
+        if (cancelFlag && *cancelFlag) {
+            std::cout << "OCR cancelled for: " << imagePath.toStdString() << std::endl;
+        } else {
+            qDebug() << "OCR timed out after" << timeoutMs << "ms for:" << imagePath;
+            std::cout << "OCR timed out after " << timeoutMs << " ms for: " << imagePath.toStdString() << std::endl;
+        }
+    }
+
+private:
+    ImageRecognition recognizeLoadedImage(tesseract::TessBaseAPI* engine, const QString& imagePath, cv::Mat image,
+                                          bool useConfidence, int minConfidence, std::vector<OcrWord>* words) {
+        ImageRecognition recognition;
+
+        // Convert to grayscale if needed
+        if (image.channels() == 3) {
+            cv::cvtColor(image, image, cv::COLOR_BGR2GRAY);
+        }
+
+        // One deadline covers every pass over this image (page, refinement
+        // crops, detected regions); the ONNX detector does not poll it either
+        RecognitionDeadline deadline(cancelFlag, imageTimeoutMs);
+
+        if (textDetector && textDetector->isLoaded()) {
+            return recognizeDetectedRegions(imagePath, image, useConfidence ? minConfidence : 0, deadline, words);
+        }
+
+        // Set image data in Tesseract
+        engine->SetImage(image.data, image.cols, image.rows, 1, image.step);
+
+        // LSTM alternatives for the ChoiceIterator are only kept on request
+        engine->SetVariable("lstm_choice_mode", corpusAnalytics ? "2" : "0");
+
+        QElapsedTimer timer;
+        timer.start();
+        recognition.status = recognizeWithDeadline(engine, imagePath, deadline);
+        if (recognition.status != ImageRecognition::Recognized) {
+            return recognition;
+        }
+        if (corpusAnalytics) {
+            recordAnalytics(engine, imagePath, image, timer.elapsed());
+        }
+        if (words) {
+            collectWords(engine, *words);
+        }
+
+        // Get mean confidence
+        recognition.confidence = engine->MeanTextConf();
+
+        if (useConfidence) {
+            int confidence = recognition.confidence;
+            qDebug() << "OCR confidence for" << QFileInfo(imagePath).fileName() << ":" << confidence << "%";
+            std::cout << "OCR confidence for " << QFileInfo(imagePath).fileName().toStdString()
+                      << ": " << confidence << "%" << std::endl;
+
+            if (confidence < minConfidence && refineLowConfidence) {
+                // Retry only the weak lines instead of discarding the whole page
+                RefinedPage refined = lineRefiner.refine(engine, image, minConfidence, deadline.monitor());
+                if (refined.interrupted) {
+                    reportAbandoned(imagePath, imageTimeoutMs);
+                    recognition.status = deadline.cancelled() ? ImageRecognition::Cancelled
+                                                              : ImageRecognition::TimedOut;
+                    return recognition;
+                }
+                if (refined.improvedLines > 0 && refined.confidence >= minConfidence) {
+                    std::cout << "OCR completed after line refinement for: " << imagePath.toStdString() << std::endl;
+                    recognition.text = refined.text;
+                    recognition.confidence = refined.confidence;
+                    return recognition;
+                }
+            }
+
+            if (confidence < minConfidence) {
+                qDebug() << "Low confidence (" << confidence << "%), skipping result for:" << imagePath;
+                std::cout << "Low confidence (" << confidence << "%), skipping result for: "
+                          << imagePath.toStdString() << std::endl;
+                return recognition;
+            }
+        }
+
+        // Get OCR result
+        char* outText = engine->GetUTF8Text();
+        if (!outText) {
+            qDebug() << "OCR failed for image:" << imagePath;
+            std::cout << "ERROR: OCR failed for image: " << imagePath.toStdString() << std::endl;
+            recognition.status = ImageRecognition::Failed;
+            return recognition;
+        }
+
+        recognition.text = QString::fromUtf8(outText);
+        delete[] outText;
+
+        std::cout << "OCR completed successfully for: " << imagePath.toStdString() << std::endl;
+        return recognition;
+    }
+
+    // Runs layout analysis and recognition on the image set in engine under
+    // deadline. Anything but Recognized leaves the engine cleared so the next
+    // image can use it.
+    ImageRecognition::Status recognizeWithDeadline(tesseract::TessBaseAPI* engine, const QString& imagePath,
+                                                   RecognitionDeadline& deadline) {
+        switch (deadline.recognize(engine)) {
+        case RecognitionDeadline::Recognized:
+            return ImageRecognition::Recognized;
+        case RecognitionDeadline::TimedOut:
+            reportAbandoned(imagePath, imageTimeoutMs);
+            return ImageRecognition::TimedOut;
+        case RecognitionDeadline::Cancelled:
+            reportAbandoned(imagePath, imageTimeoutMs);
+            return ImageRecognition::Cancelled;
+        default:
+            qDebug() << "OCR failed for image:" << imagePath;
+            std::cout << "ERROR: OCR failed for image: " << imagePath.toStdString() << std::endl;
+            return ImageRecognition::Failed;
+        }
+    }
+
+    // Recognizes each detected region as a single text line on the selected
+    // backend under deadline
+    ImageRecognition recognizeDetectedRegions(const QString& imagePath, const cv::Mat& image, int minConfidence,
+                                              RecognitionDeadline& deadline, std::vector<OcrWord>* words) {
+        ImageRecognition recognition;
+
+        QList<cv::Rect> regions = textDetector->detect(image);
+        std::cout << "Text detector found " << regions.size() << " regions in: "
+                  << QFileInfo(imagePath).fileName().toStdString() << std::endl;
+
+        QList<cv::Mat> crops;
+        for (const cv::Rect& region : regions) {
+            crops << image(region);
+        }
+
+        QStringList lines;
+        double weightedConfidence = 0.0;
+        int weight = 0;
+        QList<RecognizedLine> recognized = lineRecognizer()->recognizeLines(crops, deadline.monitor());
+        for (int i = 0; i < recognized.size(); i++) {
+            const RecognizedLine& line = recognized[i];
+            if (line.abandoned) {
+                reportAbandoned(imagePath, imageTimeoutMs);
+                recognition.status = deadline.cancelled() ? ImageRecognition::Cancelled : ImageRecognition::TimedOut;
+                return recognition;
+            }
+            if (!line.text.isEmpty()) {
+                lines << line.text;
+                weightedConfidence += line.confidence * line.text.length();
+                weight += line.text.length();
+
+                if (words) {
+                    OcrWord word;
+                    word.text = line.text;
+                    word.confidence = line.confidence;
+                    word.box = regions[i];
+                    word.line = lines.size() - 1;
+                    words->push_back(word);
+                }
+            }
+        }
+
+        recognition.status = ImageRecognition::Recognized;
+        recognition.confidence = weight > 0 ? static_cast<int>(weightedConfidence / weight + 0.5) : 0;
+        std::cout << "OCR confidence for " << QFileInfo(imagePath).fileName().toStdString()
+                  << ": " << recognition.confidence << "%" << std::endl;
+
+        if (lines.isEmpty() || recognition.confidence < minConfidence) {
+            std::cout << "Low confidence (" << recognition.confidence
+                      << "%) or no text in detected regions, skipping result for: "
+                      << imagePath.toStdString() << std::endl;
+            return recognition;
+        }
+
+        std::cout << "OCR completed successfully for: " << imagePath.toStdString() << std::endl;
+        recognition.text = lines.join("\n");
+        return recognition;
+    }
+
+    // Word confidences and symbol confusion candidates of the page just
+    // recognized on engine. A symbol recognized with less than 90% confidence
+    // contributes its runner-up choice as a confusion candidate.
+    void recordAnalytics(tesseract::TessBaseAPI* engine, const QString& imagePath, const cv::Mat& image,
+                         qint64 recognitionMs) {
+        ImageAnalytics analytics;
+        analytics.imagePath = imagePath;
+        analytics.settings = QString("%1, psm %2").arg(language).arg(pageSegMode);
+        analytics.width = image.cols;
+        analytics.height = image.rows;
+        analytics.recognitionMs = recognitionMs;
+
+        std::unique_ptr<tesseract::ResultIterator> it(engine->GetIterator());
+        if (it) {
+            it->Begin();
+            do {
+                if (it->Empty(tesseract::RIL_SYMBOL)) {
+                    continue;
+                }
+                if (it->IsAtBeginningOf(tesseract::RIL_WORD)) {
+                    float wordConfidence = qBound(0.0f, it->Confidence(tesseract::RIL_WORD), 100.0f);
+                    analytics.wordConfidences.push_back(static_cast<uint8_t>(wordConfidence + 0.5f));
+                }
+                if (it->Confidence(tesseract::RIL_SYMBOL) >= 90.0f) {
+                    continue;
+                }
+
+                char* symbolText = it->GetUTF8Text(tesseract::RIL_SYMBOL);
+                QString symbol = QString::fromUtf8(symbolText ? symbolText : "");
+                delete[] symbolText;
+
+                // The iterator starts at the recognized symbol itself
+                tesseract::ChoiceIterator choices(*it);
+                while (choices.Next()) {
+                    QString alternative = QString::fromUtf8(choices.GetUTF8Text() ? choices.GetUTF8Text() : "");
+                    if (!alternative.isEmpty() && alternative != symbol) {
+                        analytics.confusions << qMakePair(symbol, alternative);
+                        break;
+                    }
+                }
+            } while (it->Next(tesseract::RIL_SYMBOL));
+        }
+
+        corpusAnalytics->addImage(analytics);
+    }
+
+    static void collectWords(tesseract::TessBaseAPI* engine, std::vector<OcrWord>& words) {
+        std::unique_ptr<tesseract::ResultIterator> it(engine->GetIterator());
+        if (!it) {
+            return;
+        }
+
+        int line = -1;
+        it->Begin();
+        do {
+            if (it->IsAtBeginningOf(tesseract::RIL_TEXTLINE)) {
+                line++;
+            }
+            if (it->Empty(tesseract::RIL_WORD)) {
+                continue;
+            }
+
+            OcrWord word;
+            char* wordText = it->GetUTF8Text(tesseract::RIL_WORD);
+            word.text = QString::fromUtf8(wordText ? wordText : "");
+            delete[] wordText;
+            word.confidence = it->Confidence(tesseract::RIL_WORD);
+            word.line = qMax(0, line);
+
+            int left, top, right, bottom;
+            it->BoundingBox(tesseract::RIL_WORD, &left, &top, &right, &bottom);
+            word.box = cv::Rect(left, top, right - left, bottom - top);
+
+            words.push_back(std::move(word));
+        } while (it->Next(tesseract::RIL_WORD));
+    }
+
+    const std::atomic<bool>* cancelFlag;
+    QString tessdataPath;
+    tesseract::OcrEngineMode engineMode;
+    QString language;
+    int pageSegMode;
+    bool refineLowConfidence;
+    QString recognizerBackend;
+    int imageTimeoutMs;
+    OcrResultCache* resultCache;
+    CorpusAnalytics* corpusAnalytics;
+    QString textDetectorModelPath;
+    QString recognizerModelPath;
+    LowConfidenceLineRefiner lineRefiner;
+    std::unique_ptr<OnnxTextDetector> textDetector;
+    std::unique_ptr<TesseractLineRecognizer> tesseractLineRecognizer;
+    std::unique_ptr<OnnxLineRecognizer> onnxLineRecognizer;
+    std::unique_ptr<NearDuplicateIndex> nearDuplicates;
+};
+
+#endif // IMAGE_PIPELINE_H
@@ -0,0 +1,71 @@
+#ifndef IMAGE_QUEUE_H
+#define IMAGE_QUEUE_H
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QString>
+#include <QStringList>
+#include <QWaitCondition>
+#include <deque>
+
+// Image file names handed from a producer (a folder listing or a
+// FolderWatcher) to OCR workers. Every file gets its position in the queue,
+// so results can be written in the order the files were queued. Names are
+// dropped once taken, so a long watch only holds the files still waiting.
+class ImageQueue {
+public:
+    ImageQueue() : closed(false), pushed(0) {}
+
+    // Returns the file's position in the queue
+    int push(const QString& fileName) {
+        QMutexLocker locker(&mutex);
+        pending.push_back(fileName);
+        available.wakeOne();
+        return pushed++;
+    }
+
+    void push(const QStringList& fileNames) {
+        QMutexLocker locker(&mutex);
+        pending.insert(pending.end(), fileNames.begin(), fileNames.end());
+        pushed += fileNames.size();
+        available.wakeAll();
+    }
+
+    // No more files will be pushed; take() returns false once the queue is drained
+    void close() {
+        QMutexLocker locker(&mutex);
+        closed = true;
+        available.wakeAll();
+    }
+
+    // Blocks until a file is available or the queue is closed and drained
+    bool take(int& index, QString& fileName) {
+        QMutexLocker locker(&mutex);
+        while (pending.empty() && !closed) {
+            available.wait(&mutex);
+        }
+        if (pending.empty()) {
+            return false;
+        }
+
+        index = pushed - static_cast<int>(pending.size());
+        fileName = pending.front();
+        pending.pop_front();
+        return true;
+    }
+
+    // Files pushed so far, including the ones already taken
+    int size() const {
+        QMutexLocker locker(&mutex);
+        return pushed;
+    }
+
+private:
+    std::deque<QString> pending;
+    mutable QMutex mutex;
+    QWaitCondition available;
+    bool closed;
+    int pushed;
+};
+
+#endif // IMAGE_QUEUE_H
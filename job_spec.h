@@ -0,0 +1,373 @@
+#ifndef JOB_SPEC_H
+#define JOB_SPEC_H
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QFileInfo>
+#include <QList>
+#include <QSettings>
+#include <QString>
+#include <QStringList>
+
+// Everything needed to run OCR over one input folder into one output file
+struct OcrJobSpec {
+    QString name;
+    QString inputFolder;
+    QString outputFile;
+
+    // Engine settings
+    QString tessdataPath;                   // Empty = TesseractOCR default
+    QString language = "rus+ukr";
+    int pageSegmentationMode = 6;
+    int engineMode = 1;                     // Tesseract OEM; 1 = LSTM only, 3 = Tesseract's default
+    bool useConfidence = true;
+    int minConfidence = 60;
+    bool refineLowConfidence = true;
+    int imageTimeoutMs = 0;                 // 0 = no limit
+
+    // Parallelism
+    int threads = 1;                        // 0 = all available CPUs
+    int threadsPerEngine = 1;
+    QString cpus;
+    bool isolateWorkers = false;            // Worker processes instead of threads
+    int maxImageRetries = 1;                // Retries after a worker crash before quarantining
+
+    // Input filters
+    QStringList nameFilters;                // Empty = all supported image types
+    qint64 minFileSize = 0;
+    qint64 maxFileSize = 0;                 // 0 = no limit
+
+    // Watch mode: process new files as they arrive instead of the folder's contents
+    bool watch = false;
+    int watchSettleMs = 500;
+    int watchIdleExitSeconds = 0;           // 0 = watch until stopped
+
+    // Result caching
+    bool cacheResults = true;
+    QString cacheFile;                      // Empty = in-memory only
+    int nearDuplicateDistance = -1;         // Max hash bits that may differ; -1 = off
+    QString nearDuplicateHash = "dhash";    // dhash or phash
+
+    // Reports
+    QString analyticsFile;                  // Corpus analytics report; empty = off
+    QList<int> lowConfidenceThresholds = {70};  // with_confidence: percent levels counted in its statistics
+
+    // Optional ONNX front-ends
+    QString textDetectorModel;
+    QString recognizerBackend = "tesseract";
+    QString recognizerModel;
+    QString recognizerDictionary;
+    bool singleLineImages = false;
+};
+
+// Builds job specs from an INI job file and command-line flags.
+//
+// Job file layout: an optional [defaults] group applies to every job, and
+// every other group is one job named after the group:
+//
+//   [defaults]
+//   tessdata=/usr/share/tesseract-ocr/5/tessdata
+//   threads=8
+//
+//   [mly]
+//   input=/data/OCR_DATA/MLY
+//   output=/data/results/mly.txt
+//   language=rus+ukr
+//   min_confidence=60
+//
+// Command-line settings override the job file for every job. --input and
+// --output add one more job built from [defaults] and the command line.
+class OcrJobSpecLoader {
+public:
+    static void addCommandLineOptions(QCommandLineParser& parser) {
+        parser.addOption(QCommandLineOption("config", "INI job file; every group except [defaults] is a job.", "file"));
+        parser.addOption(QCommandLineOption("job", "Only run this job from the job file (repeatable).", "name"));
+        parser.addOption(QCommandLineOption("input", "Folder with images to process.", "folder"));
+        parser.addOption(QCommandLineOption("output", "File that receives all OCR results.", "file"));
+        parser.addOption(QCommandLineOption("tessdata", "Tesseract tessdata directory.", "path"));
+        parser.addOption(QCommandLineOption("language", "Tesseract language(s), e.g. rus+ukr.", "languages"));
+        parser.addOption(QCommandLineOption("psm", "Tesseract page segmentation mode.", "mode"));
+        parser.addOption(QCommandLineOption("oem", "Tesseract engine mode: 0 legacy, 1 LSTM only (default), 2 both, 3 Tesseract's default.", "mode"));
+        parser.addOption(QCommandLineOption("min-confidence", "Minimum mean confidence to accept a result.", "percent"));
+        parser.addOption(QCommandLineOption("no-confidence", "Accept results regardless of confidence."));
+        parser.addOption(QCommandLineOption("no-refine", "Do not re-recognize low-confidence lines."));
+        parser.addOption(QCommandLineOption("timeout-ms", "Give up on an image after this long (0 = no limit).", "msecs"));
+        parser.addOption(QCommandLineOption("threads", "Total thread budget (0 = all available CPUs).", "count"));
+        parser.addOption(QCommandLineOption("threads-per-engine", "OpenMP threads per Tesseract engine.", "count"));
+        parser.addOption(QCommandLineOption("cpus", "CPUs this process may use, e.g. 0-15 or 0-7,16-23.", "list"));
+        parser.addOption(QCommandLineOption("isolate", "Run workers as separate processes that are restarted after a crash."));
+        parser.addOption(QCommandLineOption("max-retries", "Retries for an image that crashed a worker before it is quarantined.", "count"));
+        parser.addOption(QCommandLineOption("extensions", "Comma-separated image extensions to include.", "list"));
+        parser.addOption(QCommandLineOption("min-size-kb", "Skip images smaller than this.", "kb"));
+        parser.addOption(QCommandLineOption("max-size-kb", "Skip images larger than this.", "kb"));
+        parser.addOption(QCommandLineOption("watch", "Watch the input folder and process new images as they arrive."));
+        parser.addOption(QCommandLineOption("settle-ms", "Watch mode: wait this long after a file's last write.", "msecs"));
+        parser.addOption(QCommandLineOption("idle-exit", "Watch mode: stop after this many seconds without new images.", "seconds"));
+        parser.addOption(QCommandLineOption("no-cache", "Do not reuse results for identical images."));
+        parser.addOption(QCommandLineOption("cache-file", "Persist the result cache in this file.", "file"));
+        parser.addOption(QCommandLineOption("near-duplicates", "Reuse results of images whose perceptual hashes differ in at most this many bits.", "bits"));
+        parser.addOption(QCommandLineOption("hash", "Perceptual hash for near-duplicates: dhash or phash.", "type"));
+        parser.addOption(QCommandLineOption("analytics", "Write corpus confidence and throughput analytics to this file.", "file"));
+        parser.addOption(QCommandLineOption("low-confidence", "with_confidence: count characters below these percents, e.g. 50,70,90.", "list"));
+        parser.addOption(QCommandLineOption("detector-model", "ONNX text detection model.", "file"));
+        parser.addOption(QCommandLineOption("recognizer", "Line recognizer backend: tesseract or onnx.", "backend"));
+        parser.addOption(QCommandLineOption("recognizer-model", "ONNX line recognition model.", "file"));
+        parser.addOption(QCommandLineOption("recognizer-dict", "Dictionary for the ONNX line recognizer.", "file"));
+        parser.addOption(QCommandLineOption("single-line", "Every image is a single text line crop."));
+    }
+
+    static QList<OcrJobSpec> load(const QCommandLineParser& parser, QString& error) {
+        QList<OcrJobSpec> jobs;
+        OcrJobSpec defaults;
+
+        if (parser.isSet("config")) {
+            QString configPath = parser.value("config");
+            if (!QFileInfo(configPath).isFile()) {
+                error = "Job file does not exist: " + configPath;
+                return jobs;
+            }
+
+            QSettings settings(configPath, QSettings::IniFormat);
+            settings.setIniCodec("UTF-8");
+            if (settings.status() != QSettings::NoError) {
+                error = "Could not parse job file: " + configPath;
+                return jobs;
+            }
+
+            settings.beginGroup("defaults");
+            applySettings(settings, defaults);
+            settings.endGroup();
+
+            QStringList selected = parser.values("job");
+            for (const QString& group : settings.childGroups()) {
+                if (group == "defaults" || (!selected.isEmpty() && !selected.contains(group))) {
+                    continue;
+                }
+
+                OcrJobSpec job = defaults;
+                job.name = group;
+                settings.beginGroup(group);
+                applySettings(settings, job);
+                settings.endGroup();
+
+                applyCommandLine(parser, job);
+                jobs << job;
+            }
+
+            for (const QString& name : selected) {
+                if (!settings.childGroups().contains(name)) {
+                    error = "Job not found in job file: " + name;
+                    return QList<OcrJobSpec>();
+                }
+            }
+        }
+
+        if (parser.isSet("input") || parser.isSet("output")) {
+            OcrJobSpec job = defaults;
+            job.name = "command-line";
+            job.inputFolder = parser.value("input");
+            job.outputFile = parser.value("output");
+            applyCommandLine(parser, job);
+            jobs << job;
+        }
+
+        for (const OcrJobSpec& job : jobs) {
+            if (!validate(job, error)) {
+                return QList<OcrJobSpec>();
+            }
+        }
+
+        return jobs;
+    }
+
+    // Settings given on the command line alone, without a job file or
+    // validation; used by worker processes
+    static OcrJobSpec fromCommandLine(const QCommandLineParser& parser) {
+        OcrJobSpec job;
+        job.name = "worker";
+        applyCommandLine(parser, job);
+        return job;
+    }
+
+    // Command line that makes a worker process recognize images the way job
+    // does (engine and recognition settings only; the parent handles files,
+    // caching and output)
+    static QStringList workerArguments(const OcrJobSpec& job) {
+        QStringList arguments;
+        if (!job.tessdataPath.isEmpty()) {
+            arguments << "--tessdata" << job.tessdataPath;
+        }
+        arguments << "--language" << job.language
+                  << "--psm" << QString::number(job.pageSegmentationMode)
+                  << "--oem" << QString::number(job.engineMode)
+                  << "--min-confidence" << QString::number(job.minConfidence)
+                  << "--timeout-ms" << QString::number(job.imageTimeoutMs)
+                  << "--threads-per-engine" << QString::number(job.threadsPerEngine)
+                  << "--recognizer" << job.recognizerBackend
+                  << "--no-cache";
+        if (job.nearDuplicateDistance >= 0) {
+            arguments << "--near-duplicates" << QString::number(job.nearDuplicateDistance)
+                      << "--hash" << job.nearDuplicateHash;
+        }
+        if (!job.useConfidence) {
+            arguments << "--no-confidence";
+        }
+        if (!job.refineLowConfidence) {
+            arguments << "--no-refine";
+        }
+        if (!job.textDetectorModel.isEmpty()) {
+            arguments << "--detector-model" << job.textDetectorModel;
+        }
+        if (job.recognizerBackend == "onnx") {
+            arguments << "--recognizer-model" << job.recognizerModel
+                      << "--recognizer-dict" << job.recognizerDictionary;
+        }
+        return arguments;
+    }
+
+private:
+    static void applySettings(const QSettings& settings, OcrJobSpec& job) {
+        job.inputFolder = settings.value("input", job.inputFolder).toString();
+        job.outputFile = settings.value("output", job.outputFile).toString();
+        job.tessdataPath = settings.value("tessdata", job.tessdataPath).toString();
+        job.language = settings.value("language", job.language).toString();
+        job.pageSegmentationMode = settings.value("psm", job.pageSegmentationMode).toInt();
+        job.engineMode = settings.value("oem", job.engineMode).toInt();
+        job.useConfidence = settings.value("use_confidence", job.useConfidence).toBool();
+        job.minConfidence = settings.value("min_confidence", job.minConfidence).toInt();
+        job.refineLowConfidence = settings.value("refine", job.refineLowConfidence).toBool();
+        job.imageTimeoutMs = settings.value("timeout_ms", job.imageTimeoutMs).toInt();
+        job.threads = settings.value("threads", job.threads).toInt();
+        job.threadsPerEngine = settings.value("threads_per_engine", job.threadsPerEngine).toInt();
+        job.cpus = settings.value("cpus", job.cpus).toStringList().join(",");
+        job.isolateWorkers = settings.value("isolate", job.isolateWorkers).toBool();
+        job.maxImageRetries = settings.value("max_retries", job.maxImageRetries).toInt();
+        if (settings.contains("extensions")) {
+            job.nameFilters = extensionFilters(settings.value("extensions").toStringList());
+        }
+        job.minFileSize = settings.value("min_size_kb", job.minFileSize / 1024).toLongLong() * 1024;
+        job.maxFileSize = settings.value("max_size_kb", job.maxFileSize / 1024).toLongLong() * 1024;
+        job.watch = settings.value("watch", job.watch).toBool();
+        job.watchSettleMs = settings.value("settle_ms", job.watchSettleMs).toInt();
+        job.watchIdleExitSeconds = settings.value("idle_exit", job.watchIdleExitSeconds).toInt();
+        job.cacheResults = settings.value("cache", job.cacheResults).toBool();
+        job.cacheFile = settings.value("cache_file", job.cacheFile).toString();
+        job.nearDuplicateDistance = settings.value("near_duplicates", job.nearDuplicateDistance).toInt();
+        job.nearDuplicateHash = settings.value("hash", job.nearDuplicateHash).toString();
+        job.analyticsFile = settings.value("analytics", job.analyticsFile).toString();
+        if (settings.contains("low_confidence")) {
+            job.lowConfidenceThresholds = thresholdList(settings.value("low_confidence").toStringList());
+        }
+        job.textDetectorModel = settings.value("detector_model", job.textDetectorModel).toString();
+        job.recognizerBackend = settings.value("recognizer", job.recognizerBackend).toString();
+        job.recognizerModel = settings.value("recognizer_model", job.recognizerModel).toString();
+        job.recognizerDictionary = settings.value("recognizer_dict", job.recognizerDictionary).toString();
+        job.singleLineImages = settings.value("single_line", job.singleLineImages).toBool();
+    }
+
+    static void applyCommandLine(const QCommandLineParser& parser, OcrJobSpec& job) {
+        if (parser.isSet("tessdata")) job.tessdataPath = parser.value("tessdata");
+        if (parser.isSet("language")) job.language = parser.value("language");
+        if (parser.isSet("psm")) job.pageSegmentationMode = parser.value("psm").toInt();
+        if (parser.isSet("oem")) job.engineMode = parser.value("oem").toInt();
+        if (parser.isSet("min-confidence")) job.minConfidence = parser.value("min-confidence").toInt();
+        if (parser.isSet("no-confidence")) job.useConfidence = false;
+        if (parser.isSet("no-refine")) job.refineLowConfidence = false;
+        if (parser.isSet("timeout-ms")) job.imageTimeoutMs = parser.value("timeout-ms").toInt();
+        if (parser.isSet("threads")) job.threads = parser.value("threads").toInt();
+        if (parser.isSet("threads-per-engine")) job.threadsPerEngine = parser.value("threads-per-engine").toInt();
+        if (parser.isSet("cpus")) job.cpus = parser.value("cpus");
+        if (parser.isSet("isolate")) job.isolateWorkers = true;
+        if (parser.isSet("max-retries")) job.maxImageRetries = parser.value("max-retries").toInt();
+        if (parser.isSet("extensions")) job.nameFilters = extensionFilters(parser.value("extensions").split(','));
+        if (parser.isSet("min-size-kb")) job.minFileSize = parser.value("min-size-kb").toLongLong() * 1024;
+        if (parser.isSet("max-size-kb")) job.maxFileSize = parser.value("max-size-kb").toLongLong() * 1024;
+        if (parser.isSet("watch")) job.watch = true;
+        if (parser.isSet("settle-ms")) job.watchSettleMs = parser.value("settle-ms").toInt();
+        if (parser.isSet("idle-exit")) job.watchIdleExitSeconds = parser.value("idle-exit").toInt();
+        if (parser.isSet("no-cache")) job.cacheResults = false;
+        if (parser.isSet("cache-file")) job.cacheFile = parser.value("cache-file");
+        if (parser.isSet("near-duplicates")) job.nearDuplicateDistance = parser.value("near-duplicates").toInt();
+        if (parser.isSet("hash")) job.nearDuplicateHash = parser.value("hash");
+        if (parser.isSet("analytics")) job.analyticsFile = parser.value("analytics");
+        if (parser.isSet("low-confidence")) job.lowConfidenceThresholds = thresholdList(parser.value("low-confidence").split(','));
+        if (parser.isSet("detector-model")) job.textDetectorModel = parser.value("detector-model");
+        if (parser.isSet("recognizer")) job.recognizerBackend = parser.value("recognizer");
+        if (parser.isSet("recognizer-model")) job.recognizerModel = parser.value("recognizer-model");
+        if (parser.isSet("recognizer-dict")) job.recognizerDictionary = parser.value("recognizer-dict");
+        if (parser.isSet("single-line")) job.singleLineImages = true;
+    }
+
+    // "png, .jpg" -> "*.png", "*.jpg"
+    static QStringList extensionFilters(const QStringList& extensions) {
+        QStringList filters;
+        for (QString extension : extensions) {
+            extension = extension.trimmed();
+            if (extension.startsWith("*.")) {
+                extension = extension.mid(2);
+            } else if (extension.startsWith(".")) {
+                extension = extension.mid(1);
+            }
+            if (!extension.isEmpty()) {
+                filters << "*." + extension;
+            }
+        }
+        return filters;
+    }
+
+    // "50, 70,90" -> 50, 70, 90; entries that are not numbers become -1 and fail validation
+    static QList<int> thresholdList(const QStringList& values) {
+        QList<int> thresholds;
+        for (const QString& value : values) {
+            if (value.trimmed().isEmpty()) {
+                continue;
+            }
+            bool ok = false;
+            int threshold = value.trimmed().toInt(&ok);
+            thresholds << (ok ? threshold : -1);
+        }
+        return thresholds;
+    }
+
+    static bool validate(const OcrJobSpec& job, QString& error) {
+        if (job.inputFolder.isEmpty() || job.outputFile.isEmpty()) {
+            error = QString("Job '%1' needs both an input folder and an output file").arg(job.name);
+            return false;
+        }
+        if (job.engineMode < 0 || job.engineMode > 3) {
+            error = QString("Job '%1' has an unknown Tesseract engine mode: %2").arg(job.name).arg(job.engineMode);
+            return false;
+        }
+        if (job.recognizerBackend != "tesseract" && job.recognizerBackend != "onnx") {
+            error = QString("Job '%1' has unknown recognizer backend: %2").arg(job.name, job.recognizerBackend);
+            return false;
+        }
+        if (job.nearDuplicateHash != "dhash" && job.nearDuplicateHash != "phash") {
+            error = QString("Job '%1' has unknown near-duplicate hash: %2").arg(job.name, job.nearDuplicateHash);
+            return false;
+        }
+        if (job.recognizerBackend == "onnx" && (job.recognizerModel.isEmpty() || job.recognizerDictionary.isEmpty())) {
+            error = QString("Job '%1' uses the onnx recognizer but has no model or dictionary").arg(job.name);
+            return false;
+        }
+        if (job.lowConfidenceThresholds.isEmpty()) {
+            error = QString("Job '%1' has no low-confidence thresholds").arg(job.name);
+            return false;
+        }
+        for (int threshold : job.lowConfidenceThresholds) {
+            if (threshold < 0 || threshold > 100) {
+                error = QString("Job '%1' has a low-confidence threshold outside 0-100").arg(job.name);
+                return false;
+            }
+        }
+        // Page images always go through Tesseract; only detected regions and line crops reach the backend
+        if (job.recognizerBackend == "onnx" && job.textDetectorModel.isEmpty() && !job.singleLineImages) {
+            error = QString("Job '%1' uses the onnx recognizer, which needs a detector model or single-line images")
+                        .arg(job.name);
+            return false;
+        }
+        return true;
+    }
+};
+
+#endif // JOB_SPEC_H
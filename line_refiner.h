@@ -0,0 +1,226 @@
+#ifndef LINE_REFINER_H
+#define LINE_REFINER_H
+
+#include <QDebug>
+#include <QList>
+#include <QString>
+#include <iostream>
+#include <memory>
+#include <opencv2/opencv.hpp>
+#include <tesseract/baseapi.h>
+#include <tesseract/ocrclass.h>
+#include <tesseract/resultiterator.h>
+#include "recognition_deadline.h"
+
+struct RefinedPage {
+    QString text;
+    int confidence = 0;     // Character-weighted mean confidence after refinement
+    int totalLines = 0;
+    int retriedLines = 0;   // Lines that were below the threshold and re-recognized
+    int improvedLines = 0;  // Lines whose re-recognized text replaced the original
+    bool interrupted = false;   // Stopped early: the monitor's deadline passed or it cancelled
+};
+
+// Re-recognizes only the low-confidence text lines of an already recognized page.
+// Each weak line is cropped from the page image, upscaled and binarized in a couple
+// of different ways, and run through the page's own engine in single-line mode, so
+// refinement needs no second engine. The best candidate is spliced back in place
+// of the original line text.
+class LowConfidenceLineRefiner {
+public:
+    LowConfidenceLineRefiner()
+        : targetLineHeight(48), maxUpscale(4.0), cropPadding(4) {}
+
+    // pageApi must hold recognition results for grayImage (e.g. after MeanTextConf).
+    // Its results are replaced by the line crops afterwards; its page
+    // segmentation mode is restored. Each crop is recognized under monitor
+    // (optional); once it stops one, the remaining lines keep their page text
+    // and the result is marked interrupted.
+    RefinedPage refine(tesseract::TessBaseAPI* pageApi, const cv::Mat& grayImage, int lineThreshold,
+                       tesseract::ETEXT_DESC* monitor = nullptr) {
+        RefinedPage page;
+
+        // Copy the line layout out first; the engine is reused for the crops below
+        QList<PageLine> lines = collectLines(pageApi);
+        page.totalLines = lines.size();
+
+        tesseract::PageSegMode pageMode = pageApi->GetPageSegMode();
+        bool singleLineMode = false;
+
+        double weightedConfidence = 0.0;
+        int weight = 0;
+
+        for (PageLine& line : lines) {
+            if (line.confidence < lineThreshold && !page.interrupted) {
+                if (!singleLineMode) {
+                    pageApi->SetPageSegMode(tesseract::PSM_SINGLE_LINE);
+                    singleLineMode = true;
+                }
+
+                page.retriedLines++;
+
+                cv::Rect box(line.box.x - cropPadding, line.box.y - cropPadding,
+                             line.box.width + 2 * cropPadding, line.box.height + 2 * cropPadding);
+                box &= cv::Rect(0, 0, grayImage.cols, grayImage.rows);
+
+                if (box.area() > 0) {
+                    QString bestText;
+                    float bestConfidence = line.confidence;
+
+                    for (const cv::Mat& variant : preprocessLine(grayImage(box))) {
+                        float candidateConfidence = 0.0f;
+                        QString candidate;
+                        if (!recognizeLine(pageApi, variant, monitor, candidate, candidateConfidence)) {
+                            // A crop that fails on its own only loses that variant
+                            page.interrupted = RecognitionDeadline::stopRequested(monitor);
+                            if (page.interrupted) {
+                                break;
+                            }
+                            continue;
+                        }
+                        if (!candidate.isEmpty() && candidateConfidence > bestConfidence) {
+                            bestText = candidate;
+                            bestConfidence = candidateConfidence;
+                        }
+                    }
+
+                    if (!bestText.isEmpty()) {
+                        line.text = bestText + "\n";
+                        line.confidence = bestConfidence;
+                        page.improvedLines++;
+                    }
+                }
+            }
+
+            // Keep the blank line Tesseract puts between paragraphs
+            if (!page.text.isEmpty() && line.startsParagraph) {
+                page.text += "\n";
+            }
+            page.text += line.text;
+
+            int lineWeight = qMax(1, line.text.trimmed().length());
+            weightedConfidence += line.confidence * lineWeight;
+            weight += lineWeight;
+        }
+
+        if (singleLineMode) {
+            pageApi->SetPageSegMode(pageMode);
+        }
+
+        if (weight > 0) {
+            page.confidence = static_cast<int>(weightedConfidence / weight + 0.5);
+        }
+
+        qDebug() << "Line refinement: retried" << page.retriedLines << "of" << page.totalLines
+                 << "lines, improved" << page.improvedLines << ", confidence now" << page.confidence << "%";
+        std::cout << "Line refinement: retried " << page.retriedLines << " of " << page.totalLines
+                  << " lines, improved " << page.improvedLines
+                  << ", confidence now " << page.confidence << "%" << std::endl;
+
+        return page;
+    }
+
+    void setTargetLineHeight(int pixels) {
+        targetLineHeight = pixels;
+    }
+
+private:
+    struct PageLine {
+        QString text;
+        float confidence;
+        cv::Rect box;
+        bool startsParagraph;
+    };
+
+    static QList<PageLine> collectLines(tesseract::TessBaseAPI* pageApi) {
+        QList<PageLine> lines;
+
+        std::unique_ptr<tesseract::ResultIterator> it(pageApi->GetIterator());
+        if (!it) {
+            return lines;
+        }
+
+        it->Begin();
+        do {
+            if (it->Empty(tesseract::RIL_TEXTLINE)) {
+                continue;
+            }
+
+            PageLine line;
+            char* lineText = it->GetUTF8Text(tesseract::RIL_TEXTLINE);
+            line.text = QString::fromUtf8(lineText ? lineText : "");
+            delete[] lineText;
+            line.confidence = it->Confidence(tesseract::RIL_TEXTLINE);
+            line.startsParagraph = it->IsAtBeginningOf(tesseract::RIL_PARA);
+
+            int left, top, right, bottom;
+            it->BoundingBox(tesseract::RIL_TEXTLINE, &left, &top, &right, &bottom);
+            line.box = cv::Rect(left, top, right - left, bottom - top);
+
+            lines << line;
+        } while (it->Next(tesseract::RIL_TEXTLINE));
+
+        return lines;
+    }
+
+    // Stronger preprocessing than the page pass: upscale small text, then try
+    // both a global (Otsu) and a local (adaptive) binarization.
+    QList<cv::Mat> preprocessLine(const cv::Mat& lineCrop) const {
+        QList<cv::Mat> variants;
+
+        double scale = qBound(1.0, static_cast<double>(targetLineHeight) / lineCrop.rows, maxUpscale);
+        cv::Mat scaled;
+        cv::resize(lineCrop, scaled, cv::Size(), scale, scale, cv::INTER_CUBIC);
+
+        cv::Mat blurred;
+        cv::GaussianBlur(scaled, blurred, cv::Size(3, 3), 0);
+
+        cv::Mat otsu;
+        cv::threshold(blurred, otsu, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
+        variants << addBorder(otsu);
+
+        cv::Mat adaptive;
+        int blockSize = qMax(3, (scaled.rows / 2) | 1);
+        cv::adaptiveThreshold(blurred, adaptive, 255, cv::ADAPTIVE_THRESH_GAUSSIAN_C,
+                              cv::THRESH_BINARY, blockSize, 10);
+        variants << addBorder(adaptive);
+
+        return variants;
+    }
+
+    static cv::Mat addBorder(const cv::Mat& binary) {
+        // Tesseract recognizes single lines noticeably better with a white margin
+        cv::Mat bordered;
+        cv::copyMakeBorder(binary, bordered, 10, 10, 10, 10, cv::BORDER_CONSTANT, cv::Scalar(255));
+        return bordered;
+    }
+
+    // Returns false if recognition failed or monitor stopped it
+    static bool recognizeLine(tesseract::TessBaseAPI* api, const cv::Mat& line, tesseract::ETEXT_DESC* monitor,
+                              QString& text, float& confidence) {
+        api->SetImage(line.data, line.cols, line.rows, 1, line.step);
+        confidence = 0.0f;
+
+        if (api->Recognize(monitor) != 0) {
+            api->Clear();
+            return false;
+        }
+
+        char* outText = api->GetUTF8Text();
+        if (!outText) {
+            return true;
+        }
+
+        text = QString::fromUtf8(outText).trimmed();
+        delete[] outText;
+
+        confidence = static_cast<float>(api->MeanTextConf());
+        return true;
+    }
+
+    int targetLineHeight;
+    double maxUpscale;
+    int cropPadding;
+};
+
+#endif // LINE_REFINER_H
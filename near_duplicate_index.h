@@ -0,0 +1,185 @@
+#ifndef NEAR_DUPLICATE_INDEX_H
+#define NEAR_DUPLICATE_INDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QString>
+#include <QtGlobal>
+#include <algorithm>
+#include <bitset>
+#include <deque>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// An image that reused the result of an earlier, nearly identical one
+struct NearDuplicateMatch {
+    QString imagePath;
+    QString originalPath;
+    int distance = 0;
+};
+
+// Perceptual hashes of recognized images, so re-captures of the same image
+// (small shifts, different compression) can reuse the earlier result instead
+// of being recognized again. Two images count as near-duplicates when their
+// 64-bit hashes differ in at most maxDistance bits. Only the latest
+// maxEntries images per settings are kept, which bounds both memory and the
+// linear lookup in long watch runs.
+//
+// dHash (gradient signs on a 9x8 thumbnail) is cheap and tolerant of
+// compression and brightness changes; pHash (signs of the low 8x8 DCT
+// frequencies of a 32x32 thumbnail) also tolerates slight blurring and scaling.
+class NearDuplicateIndex {
+public:
+    enum HashType {
+        DHash,
+        PHash
+    };
+
+    explicit NearDuplicateIndex(int maxDistance = 4, HashType hashType = DHash, int maxEntries = 10000)
+        : maxDistance(maxDistance), hashType(hashType), maxEntries(qMax(1, maxEntries)), recordMatches(true) {}
+
+    // Without recording, lookup() still reuses results but keeps no list for takeMatches()
+    void setRecordMatches(bool enabled) {
+        QMutexLocker locker(&mutex);
+        recordMatches = enabled;
+        if (!enabled) {
+            matches.clear();
+        }
+    }
+
+    quint64 hash(const cv::Mat& image) const {
+        cv::Mat gray;
+        if (image.channels() == 3) {
+            cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
+        } else {
+            gray = image;
+        }
+        return hashType == PHash ? pHash(gray) : dHash(gray);
+    }
+
+    static quint64 dHash(const cv::Mat& gray) {
+        cv::Mat thumbnail;
+        cv::resize(gray, thumbnail, cv::Size(9, 8), 0, 0, cv::INTER_AREA);
+
+        quint64 bits = 0;
+        for (int y = 0; y < 8; y++) {
+            const uchar* row = thumbnail.ptr<uchar>(y);
+            for (int x = 0; x < 8; x++) {
+                bits = (bits << 1) | (row[x] < row[x + 1] ? 1 : 0);
+            }
+        }
+        return bits;
+    }
+
+    static quint64 pHash(const cv::Mat& gray) {
+        cv::Mat thumbnail;
+        cv::resize(gray, thumbnail, cv::Size(32, 32), 0, 0, cv::INTER_AREA);
+        thumbnail.convertTo(thumbnail, CV_32F);
+
+        cv::Mat frequencies;
+        cv::dct(thumbnail, frequencies);
+
+        std::vector<float> low;
+        for (int y = 0; y < 8; y++) {
+            for (int x = 0; x < 8; x++) {
+                low.push_back(frequencies.at<float>(y, x));
+            }
+        }
+
+        // The DC term only carries overall brightness; leave it out of the median
+        std::vector<float> ac(low.begin() + 1, low.end());
+        std::nth_element(ac.begin(), ac.begin() + ac.size() / 2, ac.end());
+        float median = ac[ac.size() / 2];
+
+        quint64 bits = 0;
+        for (float value : low) {
+            bits = (bits << 1) | (value > median ? 1 : 0);
+        }
+        return bits;
+    }
+
+    static int distance(quint64 a, quint64 b) {
+        return static_cast<int>(std::bitset<64>(a ^ b).count());
+    }
+
+    // Finds the closest earlier image recognized with the same settings.
+    // Records the match for takeMatches() unless recording is off.
+    bool lookup(quint64 imageHash, const QString& settings, const QString& imagePath, QString& text) {
+        QMutexLocker locker(&mutex);
+        const std::deque<Entry>& entries = entriesBySettings[settings];
+
+        int best = -1;
+        int bestDistance = maxDistance + 1;
+        for (int i = 0; i < static_cast<int>(entries.size()) && bestDistance > 0; i++) {
+            int d = distance(imageHash, entries[i].hash);
+            if (d < bestDistance) {
+                best = i;
+                bestDistance = d;
+            }
+        }
+        if (best < 0) {
+            return false;
+        }
+
+        text = entries[best].text;
+        if (!recordMatches) {
+            return true;
+        }
+
+        NearDuplicateMatch match;
+        match.imagePath = imagePath;
+        match.originalPath = entries[best].imagePath;
+        match.distance = bestDistance;
+        matches << match;
+        return true;
+    }
+
+    void insert(quint64 imageHash, const QString& settings, const QString& imagePath, const QString& text) {
+        QMutexLocker locker(&mutex);
+        Entry entry;
+        entry.hash = imageHash;
+        entry.imagePath = imagePath;
+        entry.text = text;
+
+        std::deque<Entry>& entries = entriesBySettings[settings];
+        entries.push_back(entry);
+        if (static_cast<int>(entries.size()) > maxEntries) {
+            entries.pop_front();
+        }
+    }
+
+    // Matches found since the last call
+    QList<NearDuplicateMatch> takeMatches() {
+        QMutexLocker locker(&mutex);
+        QList<NearDuplicateMatch> taken = matches;
+        matches.clear();
+        return taken;
+    }
+
+    int getMaxDistance() const {
+        return maxDistance;
+    }
+
+    HashType getHashType() const {
+        return hashType;
+    }
+
+private:
+    struct Entry {
+        quint64 hash = 0;
+        QString imagePath;
+        QString text;
+    };
+
+    int maxDistance;
+    HashType hashType;
+    int maxEntries;
+    bool recordMatches;
+    QHash<QString, std::deque<Entry>> entriesBySettings;
+    QList<NearDuplicateMatch> matches;
+    QMutex mutex;
+};
+
+#endif // NEAR_DUPLICATE_INDEX_H
@@ -0,0 +1,355 @@
+#ifndef OCR_RECOGNIZER_H
+#define OCR_RECOGNIZER_H
+
+#include <QDebug>
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include <tesseract/baseapi.h>
+#include <tesseract/ocrclass.h>
+#include "engine_pool.h"
+#include "recognition_deadline.h"
+
+#ifdef HAVE_ONNXRUNTIME
+#include <onnxruntime_cxx_api.h>
+#endif
+
+struct RecognizedLine {
+    QString text;
+    int confidence = 0;
+    bool abandoned = false;     // Not recognized: the monitor's deadline passed or it cancelled
+};
+
+// Common interface for single-line recognizers. Inputs are crops that each
+// contain one line of text (grayscale or BGR); results come back in the same
+// order as the inputs. With a monitor, recognition stops once its deadline
+// passes or its cancel callback fires, and the remaining lines come back
+// abandoned.
+class OcrRecognizer {
+public:
+    virtual ~OcrRecognizer() {}
+
+    virtual QString name() const = 0;
+    virtual QList<RecognizedLine> recognizeLines(const QList<cv::Mat>& lines,
+                                                 tesseract::ETEXT_DESC* monitor = nullptr) = 0;
+
+    // Number of lines the backend prefers to receive per call
+    virtual int preferredBatchSize() const {
+        return 1;
+    }
+};
+
+// Tesseract backend: recognizes each crop in PSM_SINGLE_LINE mode on a pooled engine
+class TesseractLineRecognizer : public OcrRecognizer {
+public:
+    explicit TesseractLineRecognizer(TesseractEnginePool* pool) : pool(pool) {}
+
+    QString name() const override {
+        return "tesseract";
+    }
+
+    QList<RecognizedLine> recognizeLines(const QList<cv::Mat>& lines,
+                                         tesseract::ETEXT_DESC* monitor = nullptr) override {
+        QList<RecognizedLine> results;
+
+        TesseractEnginePool::EngineLease lease = pool->acquire(tesseract::PSM_SINGLE_LINE);
+        if (!lease) {
+            for (int i = 0; i < lines.size(); i++) {
+                results.append(RecognizedLine());
+            }
+            return results;
+        }
+
+        tesseract::TessBaseAPI* api = lease.engine();
+        bool stopped = false;
+        for (const cv::Mat& line : lines) {
+            RecognizedLine recognized;
+            if (stopped) {
+                recognized.abandoned = true;
+                results.append(recognized);
+                continue;
+            }
+
+            cv::Mat gray;
+            if (line.channels() == 3) {
+                cv::cvtColor(line, gray, cv::COLOR_BGR2GRAY);
+            } else {
+                gray = line;
+            }
+
+            api->SetImage(gray.data, gray.cols, gray.rows, 1, gray.step);
+            if (api->Recognize(monitor) != 0) {
+                // The line stays empty; only a passed deadline or a cancel stops the rest
+                stopped = RecognitionDeadline::stopRequested(monitor);
+                recognized.abandoned = stopped;
+                api->Clear();
+                results.append(recognized);
+                continue;
+            }
+
+            char* outText = api->GetUTF8Text();
+            if (outText) {
+                recognized.text = QString::fromUtf8(outText).trimmed();
+                recognized.confidence = api->MeanTextConf();
+                delete[] outText;
+            }
+            results.append(recognized);
+        }
+
+        return results;
+    }
+
+private:
+    TesseractEnginePool* pool;
+};
+
+// CRNN/SVTR-style line recognizer (PaddleOCR rec export layout): input is
+// Nx3xHxW normalized to [-1, 1], output is NxTxC per-timestep class
+// probabilities decoded with greedy CTC. Class 0 is the CTC blank, classes
+// 1..n map to the dictionary lines and an optional trailing class is a space.
+class OnnxLineRecognizer : public OcrRecognizer {
+public:
+    OnnxLineRecognizer() : inputHeight(48), maxInputWidth(960), batchSize(16) {}
+
+    bool load(const QString& modelPath, const QString& dictionaryPath, int intraOpThreads = 1) {
+        if (!loadDictionary(dictionaryPath)) {
+            return false;
+        }
+
+#ifdef HAVE_ONNXRUNTIME
+        try {
+            if (!env) {
+                env.reset(new Ort::Env(ORT_LOGGING_LEVEL_WARNING, "tes_cpp_line_recognizer"));
+            }
+
+            Ort::SessionOptions options;
+            options.SetIntraOpNumThreads(intraOpThreads);
+            options.SetInterOpNumThreads(1);
+            options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+
+#ifdef _WIN32
+            std::wstring path = modelPath.toStdWString();
+#else
+            std::string path = modelPath.toStdString();
+#endif
+            session.reset(new Ort::Session(*env, path.c_str(), options));
+
+            Ort::AllocatorWithDefaultOptions allocator;
+            inputName = session->GetInputNameAllocated(0, allocator).get();
+            outputName = session->GetOutputNameAllocated(0, allocator).get();
+
+            // Use the model's fixed input height when it declares one
+            std::vector<int64_t> inputShape = session->GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+            if (inputShape.size() == 4 && inputShape[2] > 0) {
+                inputHeight = static_cast<int>(inputShape[2]);
+            }
+        } catch (const Ort::Exception& e) {
+            qDebug() << "Could not load line recognition model:" << modelPath << e.what();
+            std::cout << "ERROR: Could not load line recognition model: " << modelPath.toStdString()
+                      << " (" << e.what() << ")" << std::endl;
+            session.reset();
+            return false;
+        }
+
+        std::cout << "Line recognition model loaded: " << modelPath.toStdString()
+                  << " (" << dictionary.size() << " classes, input height " << inputHeight << ")" << std::endl;
+        return true;
+#else
+        Q_UNUSED(intraOpThreads);
+        qDebug() << "Built without ONNX Runtime, cannot load line recognition model:" << modelPath;
+        std::cout << "ERROR: Built without ONNX Runtime, cannot load line recognition model: "
+                  << modelPath.toStdString() << std::endl;
+        return false;
+#endif
+    }
+
+    QString name() const override {
+        return "onnx";
+    }
+
+    int preferredBatchSize() const override {
+        return batchSize;
+    }
+
+    void setBatchSize(int lines) {
+        batchSize = qMax(1, lines);
+    }
+
+    void setMaxInputWidth(int pixels) {
+        maxInputWidth = pixels;
+    }
+
+    // The monitor is checked between batches
+    QList<RecognizedLine> recognizeLines(const QList<cv::Mat>& lines,
+                                         tesseract::ETEXT_DESC* monitor = nullptr) override {
+        QList<RecognizedLine> results;
+        for (int i = 0; i < lines.size(); i++) {
+            results.append(RecognizedLine());
+        }
+
+#ifdef HAVE_ONNXRUNTIME
+        if (!session) {
+            return results;
+        }
+
+        // Group lines of similar aspect ratio so each batch needs little padding
+        std::vector<int> order(lines.size());
+        for (int i = 0; i < lines.size(); i++) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&lines](int a, int b) {
+            return aspectRatio(lines[a]) < aspectRatio(lines[b]);
+        });
+
+        for (size_t start = 0; start < order.size(); start += batchSize) {
+            if (RecognitionDeadline::stopRequested(monitor)) {
+                for (size_t i = start; i < order.size(); i++) {
+                    results[order[i]].abandoned = true;
+                }
+                break;
+            }
+
+            std::vector<int> batch(order.begin() + start,
+                                   order.begin() + qMin(order.size(), start + batchSize));
+            runBatch(lines, batch, results);
+        }
+#else
+        Q_UNUSED(monitor);
+#endif
+        return results;
+    }
+
+private:
+    static double aspectRatio(const cv::Mat& line) {
+        return line.rows > 0 ? static_cast<double>(line.cols) / line.rows : 0.0;
+    }
+
+    bool loadDictionary(const QString& dictionaryPath) {
+        QFile file(dictionaryPath);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            qDebug() << "Could not read recognizer dictionary:" << dictionaryPath;
+            std::cout << "ERROR: Could not read recognizer dictionary: " << dictionaryPath.toStdString() << std::endl;
+            return false;
+        }
+
+        QTextStream in(&file);
+        in.setCodec("UTF-8");
+        dictionary.clear();
+        while (!in.atEnd()) {
+            dictionary << in.readLine();
+        }
+        file.close();
+
+        return !dictionary.isEmpty();
+    }
+
+#ifdef HAVE_ONNXRUNTIME
+    void runBatch(const QList<cv::Mat>& lines, const std::vector<int>& batch, QList<RecognizedLine>& results) {
+        // All lines in the batch are resized to the model height and padded to the widest one
+        std::vector<int> widths;
+        int batchWidth = 0;
+        for (int index : batch) {
+            int width = static_cast<int>(std::ceil(inputHeight * aspectRatio(lines[index])));
+            width = qBound(1, width, maxInputWidth);
+            widths.push_back(width);
+            batchWidth = qMax(batchWidth, width);
+        }
+
+        const size_t planeSize = static_cast<size_t>(inputHeight) * batchWidth;
+        std::vector<float> input(batch.size() * 3 * planeSize, 0.0f);
+
+        for (size_t b = 0; b < batch.size(); b++) {
+            const cv::Mat& line = lines[batch[b]];
+            cv::Mat bgr;
+            if (line.channels() == 1) {
+                cv::cvtColor(line, bgr, cv::COLOR_GRAY2BGR);
+            } else {
+                bgr = line;
+            }
+
+            cv::Mat resized;
+            cv::resize(bgr, resized, cv::Size(widths[b], inputHeight));
+
+            float* image = input.data() + b * 3 * planeSize;
+            for (int y = 0; y < resized.rows; y++) {
+                const cv::Vec3b* row = resized.ptr<cv::Vec3b>(y);
+                for (int x = 0; x < resized.cols; x++) {
+                    for (int c = 0; c < 3; c++) {
+                        image[c * planeSize + y * batchWidth + x] = (row[x][c] / 255.0f - 0.5f) / 0.5f;
+                    }
+                }
+            }
+        }
+
+        std::vector<int64_t> shape = {static_cast<int64_t>(batch.size()), 3, inputHeight, batchWidth};
+
+        try {
+            Ort::MemoryInfo memoryInfo = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+            Ort::Value inputTensor = Ort::Value::CreateTensor<float>(memoryInfo, input.data(), input.size(),
+                                                                     shape.data(), shape.size());
+
+            const char* inputNames[] = {inputName.c_str()};
+            const char* outputNames[] = {outputName.c_str()};
+            std::vector<Ort::Value> outputs = session->Run(Ort::RunOptions{nullptr}, inputNames,
+                                                           &inputTensor, 1, outputNames, 1);
+
+            std::vector<int64_t> outputShape = outputs[0].GetTensorTypeAndShapeInfo().GetShape();
+            const int timesteps = static_cast<int>(outputShape[1]);
+            const int classes = static_cast<int>(outputShape[2]);
+            const float* probabilities = outputs[0].GetTensorData<float>();
+
+            for (size_t b = 0; b < batch.size(); b++) {
+                results[batch[b]] = decodeCtc(probabilities + b * timesteps * classes, timesteps, classes);
+            }
+        } catch (const Ort::Exception& e) {
+            qDebug() << "Line recognition failed:" << e.what();
+            std::cout << "ERROR: Line recognition failed: " << e.what() << std::endl;
+        }
+    }
+#endif
+
+    RecognizedLine decodeCtc(const float* probabilities, int timesteps, int classes) const {
+        RecognizedLine line;
+        double confidenceSum = 0.0;
+        int emitted = 0;
+        int previous = 0;
+
+        for (int t = 0; t < timesteps; t++) {
+            const float* step = probabilities + t * classes;
+            int best = static_cast<int>(std::max_element(step, step + classes) - step);
+
+            if (best != 0 && best != previous) {
+                line.text += best - 1 < dictionary.size() ? dictionary[best - 1] : QString(" ");
+                confidenceSum += step[best];
+                emitted++;
+            }
+            previous = best;
+        }
+
+        line.text = line.text.trimmed();
+        line.confidence = emitted > 0 ? static_cast<int>(100.0 * confidenceSum / emitted + 0.5) : 0;
+        return line;
+    }
+
+    int inputHeight;
+    int maxInputWidth;
+    int batchSize;
+    QStringList dictionary;
+
+#ifdef HAVE_ONNXRUNTIME
+    std::unique_ptr<Ort::Env> env;
+    std::unique_ptr<Ort::Session> session;
+    std::string inputName;
+    std::string outputName;
+#endif
+};
+
+#endif // OCR_RECOGNIZER_H
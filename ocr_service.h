@@ -0,0 +1,315 @@
+#ifndef OCR_SERVICE_H
+#define OCR_SERVICE_H
+
+#include <QByteArray>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QString>
+#include <QWaitCondition>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <tesseract/baseapi.h>
+#include "engine_pool.h"
+#include "image_pipeline.h"
+#include "thread_placement.h"
+
+// Result of one submitted image. Move-only, so the text and word list are
+// handed to the caller without being copied.
+struct OcrResult {
+    OcrResult() = default;
+    OcrResult(OcrResult&&) = default;
+    OcrResult& operator=(OcrResult&&) = default;
+    OcrResult(const OcrResult&) = delete;
+    OcrResult& operator=(const OcrResult&) = delete;
+
+    QString label;              // Path or label given at submission
+    bool ok = false;
+    bool timedOut = false;
+    QString error;              // Why ok is false
+    QString text;               // Empty below minConfidence
+    int meanConfidence = -1;    // -1 for results reused from the cache or a near-duplicate
+    std::vector<OcrWord> words; // Empty for reused results
+    qint64 elapsedMs = 0;       // Recognition time, excluding time in the queue
+};
+
+struct OcrServiceOptions {
+    QString tessdataPath;
+    QString language = "rus+ukr";
+    int pageSegmentationMode = 6;
+    tesseract::OcrEngineMode engineMode = tesseract::OEM_LSTM_ONLY;
+    int threads = 1;                        // 0 = all available CPUs
+    int threadsPerEngine = 1;
+    QString cpus;
+    int imageTimeoutMs = 0;                 // 0 = no limit
+
+    // The rest matches the TesseractOCR settings of the same name
+    bool useConfidence = false;
+    int minConfidence = 60;
+    bool refineLowConfidenceLines = true;
+    QString textDetectorModel;              // Empty = Tesseract layout analysis
+    QString recognizerBackend = "tesseract";
+    QString recognizerModel;                // Required for the "onnx" backend
+    QString recognizerDictionary;
+    int onnxThreads = 1;
+    int onnxBatchSize = 16;
+    int nearDuplicateDistance = -1;         // -1 = off
+    QString nearDuplicateHash = "dhash";
+    OcrResultCache* resultCache = nullptr;  // Not owned
+    CorpusAnalytics* corpusAnalytics = nullptr;     // Not owned
+};
+
+// In-process OCR for embedding in other programs. Images (encoded bytes or
+// file paths) are queued and recognized on pinned worker threads, one pooled
+// engine per worker, through the same OcrImagePipeline as TesseractOCR; each
+// submission resolves a future or invokes a callback with the structured
+// result. Callbacks run on a worker thread. If a model in the options cannot
+// be loaded, every submission fails with that error.
+//
+//   OcrService ocr(options);
+//   std::future<OcrResult> pending = ocr.submitFile("/data/scan.png");
+//   OcrResult result = pending.get();
+class OcrService {
+public:
+    typedef std::function<void(OcrResult&&)> Callback;
+
+    explicit OcrService(const OcrServiceOptions& options)
+        : options(options), closed(false), cancelRequested(false), pipeline(&cancelRequested) {
+        QList<WorkerPlacement> placements = ThreadPlacement::plan(options.threads, options.threadsPerEngine,
+                                                                  options.cpus);
+        pool.reset(new TesseractEnginePool(options.tessdataPath, options.language, placements.size(),
+                                           options.engineMode));
+        linePool.reset(new TesseractEnginePool(options.tessdataPath, options.language, placements.size(),
+                                               options.engineMode));
+        configurePipeline();
+
+        for (int w = 0; w < placements.size(); w++) {
+            const WorkerPlacement placement = placements[w];
+            workers.emplace_back([this, w, placement]() {
+                run(w, placement);
+            });
+        }
+    }
+
+    // Finishes every queued image before returning; call shutdown(true) first to drop them
+    ~OcrService() {
+        shutdown();
+    }
+
+    OcrService(const OcrService&) = delete;
+    OcrService& operator=(const OcrService&) = delete;
+
+    std::future<OcrResult> submit(QByteArray imageBytes, const QString& label = QString()) {
+        Job job;
+        job.imageBytes = std::move(imageBytes);
+        job.label = label;
+        std::future<OcrResult> future = job.promise.get_future();
+        enqueue(std::move(job));
+        return future;
+    }
+
+    std::future<OcrResult> submitFile(const QString& imagePath) {
+        Job job;
+        job.imagePath = imagePath;
+        job.label = imagePath;
+        std::future<OcrResult> future = job.promise.get_future();
+        enqueue(std::move(job));
+        return future;
+    }
+
+    void submit(QByteArray imageBytes, const QString& label, Callback callback) {
+        Job job;
+        job.imageBytes = std::move(imageBytes);
+        job.label = label;
+        job.callback = std::move(callback);
+        enqueue(std::move(job));
+    }
+
+    void submitFile(const QString& imagePath, Callback callback) {
+        Job job;
+        job.imagePath = imagePath;
+        job.label = imagePath;
+        job.callback = std::move(callback);
+        enqueue(std::move(job));
+    }
+
+    // Images submitted but not yet picked up by a worker
+    int pendingCount() const {
+        QMutexLocker locker(&mutex);
+        return static_cast<int>(jobs.size());
+    }
+
+    // Stops accepting images and waits for the workers. With cancelPending,
+    // queued images resolve with an error and images being recognized are
+    // abandoned; otherwise everything queued is recognized first.
+    void shutdown(bool cancelPending = false) {
+        {
+            QMutexLocker locker(&mutex);
+            closed = true;
+            if (cancelPending) {
+                cancelRequested = true;
+            }
+            available.wakeAll();
+        }
+
+        for (std::thread& worker : workers) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+    }
+
+private:
+    struct Job {
+        QByteArray imageBytes;
+        QString imagePath;      // Read by the worker when imageBytes is empty
+        QString label;
+        std::promise<OcrResult> promise;
+        Callback callback;
+    };
+
+    void enqueue(Job job) {
+        QMutexLocker locker(&mutex);
+        if (closed) {
+            locker.unlock();
+            deliver(job, failed(job.label, "OCR service is shut down"));
+            return;
+        }
+        jobs.push_back(std::move(job));
+        available.wakeOne();
+    }
+
+    bool take(Job& job) {
+        QMutexLocker locker(&mutex);
+        while (jobs.empty() && !closed) {
+            available.wait(&mutex);
+        }
+        if (jobs.empty()) {
+            return false;
+        }
+        job = std::move(jobs.front());
+        jobs.pop_front();
+        return true;
+    }
+
+    void run(int slot, const WorkerPlacement& placement) {
+        if (!ThreadPlacement::pinCurrentThread(placement.cpus)) {
+            qDebug() << "Could not pin OCR service worker to CPUs" << placement.cpus;
+        }
+
+        // Acquired after pinning, so the engine's memory is local to the worker
+        TesseractEnginePool::EngineLease lease = pool->acquireSlot(options.pageSegmentationMode, slot);
+
+        Job job;
+        while (take(job)) {
+            if (cancelRequested) {
+                deliver(job, failed(job.label, "Cancelled"));
+            } else if (!setupError.isEmpty()) {
+                deliver(job, failed(job.label, setupError));
+            } else if (!lease) {
+                deliver(job, failed(job.label, "Could not initialize the OCR engine for " + options.language));
+            } else {
+                deliver(job, recognize(lease.engine(), job));
+            }
+        }
+    }
+
+    // Loads the optional models into the pipeline; the first failure becomes setupError
+    void configurePipeline() {
+        pipeline.setModel(options.tessdataPath, options.engineMode);
+        pipeline.setPageSettings(options.language, options.pageSegmentationMode);
+        pipeline.setImageTimeout(options.imageTimeoutMs);
+        pipeline.setRefineLowConfidenceLines(options.refineLowConfidenceLines);
+        pipeline.setResultCache(options.resultCache);
+        pipeline.setCorpusAnalytics(options.corpusAnalytics);
+        // No duplicates report to write, so matches are not kept
+        pipeline.setNearDuplicateDetection(options.nearDuplicateDistance, options.nearDuplicateHash, false);
+        pipeline.setLineEnginePool(linePool.get());
+
+        if (!pipeline.setTextDetectorModel(options.textDetectorModel, options.onnxThreads)) {
+            setupError = "Could not load text detector model: " + options.textDetectorModel;
+        } else if (options.recognizerBackend == "onnx" &&
+                   !pipeline.setOnnxLineRecognizer(options.recognizerModel, options.recognizerDictionary,
+                                                   options.onnxThreads, options.onnxBatchSize)) {
+            setupError = "Could not load ONNX line recognizer: " + options.recognizerModel;
+        } else if (!pipeline.setRecognizerBackend(options.recognizerBackend)) {
+            setupError = "Unknown recognizer backend: " + options.recognizerBackend;
+        }
+    }
+
+    OcrResult recognize(tesseract::TessBaseAPI* engine, Job& job) {
+        if (job.imageBytes.isEmpty() && !OcrImagePipeline::readImageFile(job.imagePath, job.imageBytes)) {
+            return failed(job.label, "Could not read image: " + job.imagePath);
+        }
+
+        OcrResult result;
+        result.label = job.label;
+
+        QElapsedTimer timer;
+        timer.start();
+        ImageRecognition recognition = pipeline.recognize(engine, job.label, std::move(job.imageBytes),
+                                                          options.useConfidence, options.minConfidence,
+                                                          &result.words);
+        job.imageBytes.clear();
+        result.elapsedMs = timer.elapsed();
+
+        switch (recognition.status) {
+        case ImageRecognition::Recognized:
+            result.ok = true;
+            result.text = recognition.text;
+            result.meanConfidence = recognition.confidence;
+            break;
+        case ImageRecognition::Unreadable:
+            result.error = "Could not decode image";
+            break;
+        case ImageRecognition::TimedOut:
+            result.timedOut = true;
+            result.error = "Timed out";
+            break;
+        case ImageRecognition::Cancelled:
+            result.error = "Cancelled";
+            break;
+        default:
+            result.error = "Recognition failed";
+            break;
+        }
+        return result;
+    }
+
+    static OcrResult failed(const QString& label, const QString& error) {
+        OcrResult result;
+        result.label = label;
+        result.error = error;
+        return result;
+    }
+
+    static void deliver(Job& job, OcrResult&& result) {
+        if (job.callback) {
+            job.callback(std::move(result));
+        } else {
+            job.promise.set_value(std::move(result));
+        }
+    }
+
+    OcrServiceOptions options;
+    std::unique_ptr<TesseractEnginePool> pool;
+    std::unique_ptr<TesseractEnginePool> linePool;
+    std::vector<std::thread> workers;
+    std::deque<Job> jobs;
+    mutable QMutex mutex;
+    QWaitCondition available;
+    bool closed;
+    std::atomic<bool> cancelRequested;
+    OcrImagePipeline pipeline;          // Uses linePool and cancelRequested; declared after them
+    QString setupError;
+};
+
+#endif // OCR_SERVICE_H
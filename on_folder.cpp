@@ -1,390 +1,226 @@
 #include <QCoreApplication>
 #include <QDebug>
-#include <QFile>
-#include <QTextStream>
-#include <QString>
 #include <QDir>
-#include <QStandardPaths>
 #include <QFileInfo>
-#include <QStringList>
-#include <QDateTime>
-#include <QByteArray>
+#include <QString>
+#include <QCommandLineParser>
 #include <iostream>
-#include <opencv2/opencv.hpp>
-#include <tesseract/baseapi.h>
-#include <leptonica/allheaders.h>
-
-class TesseractOCR {
+#include <map>
+#include <memory>
+#include "tesseract_ocr.h"
+#include "job_spec.h"
+#include "result_cache.h"
+#include "worker_process.h"
+#include "thread_placement.h"
+#include "corpus_analytics.h"
+
+// Runs a list of jobs in one process. Jobs with the same tessdata path and
+// language share one TesseractOCR instance, so their engines stay warm from
+// one job to the next; jobs with the same cache file share one result cache.
+class OcrJobRunner {
 public:
-    TesseractOCR() {
-        api = nullptr;
-
-        // Set the path to tessdata directory
-        tessdataPath = "C:/Program Files/Tesseract-OCR/tessdata";
-
-        // Supported image extensions
-        supportedExtensions << "*.png" << "*.jpg" << "*.jpeg"
-                           << "*.tiff" << "*.tif" << "*.bmp"
-                           << "*.gif" << "*.webp";
-    }
-
-    ~TesseractOCR() {
-        cleanup();
-    }
-
-    bool initialize(const QString& language = "eng",int pageSegmentationMode = 6) {
-        cleanup(); // Clean up any existing instance
-
-        api = new tesseract::TessBaseAPI();
-
-        // Initialize tesseract-ocr with language
-        if (api->Init(tessdataPath.toStdString().c_str(), language.toStdString().c_str())) {
-            qDebug() << "Could not initialize tesseract with language:" << language;
-            qDebug() << "Make sure tessdata path exists:" << tessdataPath;
-
-            // Check if tessdata path exists
-            QDir tessdataDir(tessdataPath);
-            if (!tessdataDir.exists()) {
-                qDebug() << "ERROR: tessdata directory does not exist!";
-                std::cout << "ERROR: tessdata directory does not exist: " << tessdataPath.toStdString() << std::endl;
+    // Returns the number of failed jobs
+    int run(const QList<OcrJobSpec>& jobs) {
+        int failedJobs = 0;
+        for (const OcrJobSpec& job : jobs) {
+            std::cout << "\n=== Job: " << job.name.toStdString() << " ===" << std::endl;
+            if (!runJob(job)) {
+                std::cout << "ERROR: Job failed: " << job.name.toStdString() << std::endl;
+                failedJobs++;
             }
 
-            delete api;
-            api = nullptr;
-            return false;
-        }
-        // Set Page Segmentation Mode
-           api->SetPageSegMode(static_cast<tesseract::PageSegMode>(pageSegmentationMode));
-
-
-        qDebug() << "Tesseract initialized successfully with language:" << language;
-        std::cout << "Tesseract initialized successfully with language: " << language.toStdString() << std::endl;
-        return true;
-    }
-
-    void cleanup() {
-        if (api) {
-            api->End();
-            delete api;
-            api = nullptr;
-        }
-    }
-
-
-    QString processImage(const QString& imagePath) {
-        if (!api) {
-            qDebug() << "Tesseract not initialized. Call initialize() first.";
-            std::cout << "ERROR: Tesseract not initialized!" << std::endl;
-            return QString();
-        }
-
-        // Load image using OpenCV
-        cv::Mat image = cv::imread(imagePath.toStdString());
-        if (image.empty()) {
-            qDebug() << "Could not load image:" << imagePath;
-            std::cout << "ERROR: Could not load image: " << imagePath.toStdString() << std::endl;
-            return QString();
-        }
-
-        std::cout << "Successfully loaded image: " << imagePath.toStdString() << std::endl;
-
-        // Convert to grayscale if needed
-        if (image.channels() == 3) {
-            cv::cvtColor(image, image, cv::COLOR_BGR2GRAY);
+            // Keep the corpus reports current after every job
+            for (auto it = analytics.begin(); it != analytics.end(); ++it) {
+                it->second->saveReport();
+            }
         }
 
-        // Set image data in Tesseract
-        api->SetImage(image.data, image.cols, image.rows, 1, image.step);
-
-        // Get OCR result
-        char* outText = api->GetUTF8Text();
-        if (!outText) {
-            qDebug() << "OCR failed for image:" << imagePath;
-            std::cout << "ERROR: OCR failed for image: " << imagePath.toStdString() << std::endl;
-            return QString();
+        std::cout << "\n=== All Jobs Complete ===" << std::endl;
+        std::cout << "Jobs run: " << jobs.size() << ", failed: " << failedJobs << std::endl;
+        for (auto it = caches.begin(); it != caches.end(); ++it) {
+            std::cout << "Result cache " << (it->first.isEmpty() ? "(in-memory)" : it->first.toStdString())
+                      << ": " << it->second->hitCount() << " hits, " << it->second->missCount() << " misses" << std::endl;
         }
-
-        QString result = QString::fromUtf8(outText);
-        delete[] outText;
-
-        std::cout << "OCR completed for: " << imagePath.toStdString() << std::endl;
-        return result;
+        return failedJobs;
     }
 
-    QString processImageWithConfidence(const QString& imagePath, int minConfidence = 60) {
-        if (!api) {
-            qDebug() << "Tesseract not initialized. Call initialize() first.";
-            std::cout << "ERROR: Tesseract not initialized!" << std::endl;
-            return QString();
-        }
-
-        // Load image using OpenCV
-        cv::Mat image = cv::imread(imagePath.toStdString());
-        if (image.empty()) {
-            qDebug() << "Could not load image:" << imagePath;
-            std::cout << "ERROR: Could not load image: " << imagePath.toStdString() << std::endl;
-            return QString();
-        }
-
-        std::cout << "Successfully loaded image: " << imagePath.toStdString() << std::endl;
+private:
+    bool runJob(const OcrJobSpec& job) {
+        std::cout << "Input folder path: " << job.inputFolder.toStdString() << std::endl;
+        std::cout << "Output file path: " << job.outputFile.toStdString() << std::endl;
 
-        // Convert to grayscale if needed
-        if (image.channels() == 3) {
-            cv::cvtColor(image, image, cv::COLOR_BGR2GRAY);
+        // Check if input folder exists
+        QDir inputDir(job.inputFolder);
+        if (!inputDir.exists()) {
+            std::cout << "ERROR: Input folder does not exist!" << std::endl;
+            std::cout << "Please check the path: " << job.inputFolder.toStdString() << std::endl;
+            return false;
         }
 
-        // Set image data in Tesseract
-        api->SetImage(image.data, image.cols, image.rows, 1, image.step);
-
-        // Get mean confidence
-        int confidence = api->MeanTextConf();
-        qDebug() << "OCR confidence for" << QFileInfo(imagePath).fileName() << ":" << confidence << "%";
-        std::cout << "OCR confidence for " << QFileInfo(imagePath).fileName().toStdString()
-                  << ": " << confidence << "%" << std::endl;
-
-        if (confidence < minConfidence) {
-            qDebug() << "Low confidence (" << confidence << "%), skipping result for:" << imagePath;
-            std::cout << "Low confidence (" << confidence << "%), skipping result for: "
-                      << imagePath.toStdString() << std::endl;
-            return QString();
+        // Check if output directory exists
+        QDir outputDir = QFileInfo(job.outputFile).absoluteDir();
+        if (!outputDir.exists()) {
+            std::cout << "Creating output directory: " << outputDir.absolutePath().toStdString() << std::endl;
+            if (!outputDir.mkpath(".")) {
+                std::cout << "ERROR: Could not create output directory!" << std::endl;
+                return false;
+            }
         }
 
-        // Get OCR result
-        char* outText = api->GetUTF8Text();
-        if (!outText) {
-            qDebug() << "OCR failed for image:" << imagePath;
-            std::cout << "ERROR: OCR failed for image: " << imagePath.toStdString() << std::endl;
-            return QString();
+        TesseractOCR& ocr = engineFor(job);
+        ocr.setEngineMode(static_cast<tesseract::OcrEngineMode>(job.engineMode));
+        ocr.setThreadBudget(job.threads, job.threadsPerEngine, job.cpus);
+        ocr.setRefineLowConfidenceLines(job.refineLowConfidence);
+        ocr.setFileFilters(job.nameFilters, job.minFileSize, job.maxFileSize);
+        ocr.setResultCache(job.cacheResults ? cacheFor(job.cacheFile) : nullptr);
+        ocr.setCorpusAnalytics(job.analyticsFile.isEmpty() ? nullptr : analyticsFor(job.analyticsFile));
+        if (!job.analyticsFile.isEmpty() && job.isolateWorkers) {
+            std::cout << "WARNING: Corpus analytics are not collected from isolated worker processes" << std::endl;
         }
+        ocr.setSingleLineImages(job.singleLineImages);
+        ocr.setImageTimeout(job.imageTimeoutMs);
+        ocr.setNearDuplicateDetection(job.nearDuplicateDistance, job.nearDuplicateHash);
+        ocr.setProcessIsolation(job.isolateWorkers, OcrJobSpecLoader::workerArguments(job), job.maxImageRetries);
 
-        QString result = QString::fromUtf8(outText);
-        delete[] outText;
-
-        std::cout << "OCR completed successfully for: " << imagePath.toStdString() << std::endl;
-        return result;
-    }
-
-    bool saveToFile(const QString& text, const QString& outputPath) {
-        QFile file(outputPath);
-        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-            qDebug() << "Could not create output file:" << outputPath;
-            std::cout << "ERROR: Could not create output file: " << outputPath.toStdString() << std::endl;
+        if (!ocr.setTextDetectorModel(job.textDetectorModel, job.threadsPerEngine)) {
             return false;
         }
-
-        QTextStream out(&file);
-        out.setCodec("UTF-8");
-        out << text;
-        file.close();
-
-        qDebug() << "Text saved to:" << outputPath;
-        std::cout << "Text saved to: " << outputPath.toStdString() << std::endl;
-        return true;
-    }
-
-    bool processFolder(const QString& folderPath, const QString& outputFile,
-                      const QString& language = "rus+ukr", bool useConfidence = false, int minConfidence = 60,int pageSegmentationMode = 6) {
-
-        std::cout << "Starting processFolder with:" << std::endl;
-        std::cout << "  Folder: " << folderPath.toStdString() << std::endl;
-        std::cout << "  Output: " << outputFile.toStdString() << std::endl;
-        std::cout << "  Language: " << language.toStdString() << std::endl;
-
-        if (!initialize(language,pageSegmentationMode)) {
-            std::cout << "ERROR: Failed to initialize Tesseract!" << std::endl;
+        if (job.recognizerBackend == "onnx"
+                && !ocr.setOnnxLineRecognizer(job.recognizerModel, job.recognizerDictionary, job.threadsPerEngine)) {
             return false;
         }
-
-        QDir inputDir(folderPath);
-        if (!inputDir.exists()) {
-            qDebug() << "Input folder does not exist:" << folderPath;
-            std::cout << "ERROR: Input folder does not exist: " << folderPath.toStdString() << std::endl;
+        if (!ocr.setRecognizerBackend(job.recognizerBackend)) {
             return false;
         }
 
-        std::cout << "Input folder exists and is accessible." << std::endl;
-
-        // Get all image files in the folder
-        QStringList imageFiles;
-        for (const QString& extension : supportedExtensions) {
-            QStringList matchingFiles = inputDir.entryList(QStringList() << extension, QDir::Files);
-            imageFiles.append(matchingFiles);
-            std::cout << "Found " << matchingFiles.count() << " files matching "
-                      << extension.toStdString() << std::endl;
+        if (job.watch) {
+            ocr.setWatchSettleTime(job.watchSettleMs);
+            qDebug() << "Watching folder for new images:" << job.inputFolder;
+            return ocr.watchFolder(job.inputFolder, job.outputFile, job.language, job.useConfidence,
+                                   job.minConfidence, job.pageSegmentationMode, job.watchIdleExitSeconds);
         }
 
-        if (imageFiles.isEmpty()) {
-            qDebug() << "No image files found in folder:" << folderPath;
-            std::cout << "ERROR: No image files found in folder: " << folderPath.toStdString() << std::endl;
-
-            // List all files in directory for debugging
-            QStringList allFiles = inputDir.entryList(QDir::Files);
-            std::cout << "All files in directory:" << std::endl;
-            for (const QString& file : allFiles) {
-                std::cout << "  " << file.toStdString() << std::endl;
-            }
-
-            return false;
-        }
+        qDebug() << "Starting OCR processing for folder:" << job.inputFolder;
+        std::cout << "Starting OCR processing for folder: " << job.inputFolder.toStdString() << std::endl;
 
-        qDebug() << "Found" << imageFiles.count() << "image files to process";
-        std::cout << "Found " << imageFiles.count() << " image files to process" << std::endl;
+        return ocr.processFolder(job.inputFolder, job.outputFile, job.language,
+                                 job.useConfidence, job.minConfidence, job.pageSegmentationMode);
+    }
 
-        // Create/open the single output file
-        QFile file(outputFile);
-        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-            qDebug() << "Could not create output file:" << outputFile;
-            std::cout << "ERROR: Could not create output file: " << outputFile.toStdString() << std::endl;
-            return false;
+    TesseractOCR& engineFor(const OcrJobSpec& job) {
+        QString key = job.tessdataPath + "|" + job.language;
+        std::unique_ptr<TesseractOCR>& ocr = engines[key];
+        if (!ocr) {
+            ocr.reset(new TesseractOCR());
+            if (!job.tessdataPath.isEmpty()) {
+                ocr->setTessdataPath(job.tessdataPath);
+            }
         }
+        return *ocr;
+    }
 
-        std::cout << "Output file created successfully." << std::endl;
-
-        QTextStream out(&file);
-        out.setCodec("UTF-8");
-
-        int successCount = 0;
-        int failCount = 0;
-
-        // Write header to the file
-        out << "OCR Results for folder: " << folderPath << "\n";
-        out << "Generated on: " << QDateTime::currentDateTime().toString() << "\n";
-        out << "Language: " << language << "\n";
-        out << "Total images: " << imageFiles.count() << "\n";
-        if (useConfidence) {
-            out << "Minimum confidence: " << minConfidence << "%\n";
+    OcrResultCache* cacheFor(const QString& cacheFile) {
+        std::unique_ptr<OcrResultCache>& cache = caches[cacheFile];
+        if (!cache) {
+            cache.reset(new OcrResultCache(cacheFile));
         }
-        out << QString("=").repeated(80) << "\n\n";
-
-        // Process each image file
-        for (const QString& fileName : imageFiles) {
-            QString fullImagePath = inputDir.absoluteFilePath(fileName);
-
-            qDebug() << "\n--- Processing:" << fileName << "---";
-            std::cout << "\n--- Processing: " << fileName.toStdString() << " ---" << std::endl;
-
-            QString ocrResult;
-            if (useConfidence) {
-                ocrResult = processImageWithConfidence(fullImagePath, minConfidence);
-            } else {
-                ocrResult = processImage(fullImagePath);
-            }
-
-            if (!ocrResult.isEmpty()) {
-                // Write to single file with filename header
-                out << "File: " << fileName << "\n";
-                out << QString("-").repeated(40) << "\n";
-                out << ocrResult.trimmed() << "\n\n";
-                out << QString("=").repeated(80) << "\n\n";
-
-                qDebug() << "✓ Successfully processed:" << fileName;
-                std::cout << "✓ Successfully processed: " << fileName.toStdString() << std::endl;
-                successCount++;
-            } else {
-                // Write failure notice to file
-                out << "File: " << fileName << "\n";
-                out << QString("-").repeated(40) << "\n";
-                if (useConfidence) {
-                    out << "[OCR FAILED - Low confidence or no text detected]\n\n";
-                } else {
-                    out << "[OCR FAILED - No text detected]\n\n";
-                }
-                out << QString("=").repeated(80) << "\n\n";
-
-                qDebug() << "✗ OCR failed for:" << fileName;
-                std::cout << "✗ OCR failed for: " << fileName.toStdString() << std::endl;
-                failCount++;
-            }
+        return cache.get();
+    }
 
-            // Flush the output periodically
-            out.flush();
+    // Jobs naming the same report file add to the same corpus analytics
+    CorpusAnalytics* analyticsFor(const QString& reportFile) {
+        std::unique_ptr<CorpusAnalytics>& corpus = analytics[reportFile];
+        if (!corpus) {
+            corpus.reset(new CorpusAnalytics(reportFile));
         }
+        return corpus.get();
+    }
 
-        // Write summary at the end of file
-        out << "\n" << QString("=").repeated(80) << "\n";
-        out << "PROCESSING SUMMARY\n";
-        out << QString("=").repeated(80) << "\n";
-        out << "Successfully processed: " << successCount << " files\n";
-        out << "Failed: " << failCount << " files\n";
-        out << "Total files: " << imageFiles.count() << "\n";
-
-        file.close();
-
-        qDebug() << "\n=== Processing Complete ===";
-        qDebug() << "Successfully processed:" << successCount << "files";
-        qDebug() << "Failed:" << failCount << "files";
-        qDebug() << "Total files:" << imageFiles.count();
-        qDebug() << "All results saved to:" << outputFile;
-
-        std::cout << "\n=== Processing Complete ===" << std::endl;
-        std::cout << "Successfully processed: " << successCount << " files" << std::endl;
-        std::cout << "Failed: " << failCount << " files" << std::endl;
-        std::cout << "Total files: " << imageFiles.count() << std::endl;
-        std::cout << "All results saved to: " << outputFile.toStdString() << std::endl;
+    std::map<QString, std::unique_ptr<TesseractOCR>> engines;
+    std::map<QString, std::unique_ptr<OcrResultCache>> caches;
+    std::map<QString, std::unique_ptr<CorpusAnalytics>> analytics;
+};
 
-        return successCount > 0;
+// Worker process mode (--worker-server, see OcrWorkerProcess): loads one
+// engine with the settings from the command line and recognizes the images
+// the parent sends until it quits
+static int runOcrWorker(const OcrJobSpec& spec, const QString& serverName) {
+    // Pin before the engine exists so its memory lands on the local NUMA node
+    QList<int> cpus = ThreadPlacement::parseCpuList(spec.cpus);
+    if (!cpus.isEmpty() && !ThreadPlacement::pinCurrentThread(cpus)) {
+        qDebug() << "Could not pin OCR worker to CPUs" << cpus;
     }
 
-    void setTessdataPath(const QString& path) {
-        tessdataPath = path;
+    TesseractOCR ocr;
+    if (!spec.tessdataPath.isEmpty()) {
+        ocr.setTessdataPath(spec.tessdataPath);
     }
+    ocr.setEngineMode(static_cast<tesseract::OcrEngineMode>(spec.engineMode));
+    ocr.setRefineLowConfidenceLines(spec.refineLowConfidence);
+    ocr.setImageTimeout(spec.imageTimeoutMs);
+    ocr.setNearDuplicateDetection(spec.nearDuplicateDistance, spec.nearDuplicateHash, false);
 
-    QStringList getSupportedExtensions() const {
-        return supportedExtensions;
+    if (!ocr.setTextDetectorModel(spec.textDetectorModel, spec.threadsPerEngine)) {
+        return 1;
+    }
+    if (spec.recognizerBackend == "onnx"
+            && !ocr.setOnnxLineRecognizer(spec.recognizerModel, spec.recognizerDictionary, spec.threadsPerEngine)) {
+        return 1;
+    }
+    if (!ocr.initialize(spec.language, spec.pageSegmentationMode) || !ocr.setRecognizerBackend(spec.recognizerBackend)) {
+        return 1;
     }
 
-private:
-    tesseract::TessBaseAPI* api;
-    QString tessdataPath;
-    QStringList supportedExtensions;
-};
+    return OcrWorkerProcess::serve(serverName, [&](const QByteArray& imageBytes, const QString& label, bool& timedOut) {
+        return ocr.processImageData(imageBytes, label, spec.useConfidence, spec.minConfidence, &timedOut);
+    });
+}
 
 int main(int argc, char *argv[])
 {
     std::cout << "=== OCR Application Starting ===" << std::endl;
     QCoreApplication app(argc, argv);
 
-    TesseractOCR ocr;
-    std::cout << "TesseractOCR object created" << std::endl;
-
-    // Path to your folder containing images
-    QString folderPath = "D:/Dataset/OCR_DATA/MLY/";
-    std::cout << "Input folder path: " << folderPath.toStdString() << std::endl;
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs Tesseract OCR on every image in a folder.\n"
+                                     "Jobs come from --input/--output or from a --config job file.");
+    parser.addHelpOption();
+    OcrJobSpecLoader::addCommandLineOptions(parser);
+    QCommandLineOption workerOption("worker-server", "Internal: run as an OCR worker process.", "name");
+    workerOption.setFlags(QCommandLineOption::HiddenFlag);
+    parser.addOption(workerOption);
+    parser.process(app);
+
+    if (parser.isSet(workerOption)) {
+        return runOcrWorker(OcrJobSpecLoader::fromCommandLine(parser), parser.value(workerOption));
+    }
 
-    // Check if input folder exists
-    QDir inputDir(folderPath);
-    if (!inputDir.exists()) {
-        std::cout << "ERROR: Input folder does not exist!" << std::endl;
-        std::cout << "Please check the path: " << folderPath.toStdString() << std::endl;
+    QString error;
+    QList<OcrJobSpec> jobs = OcrJobSpecLoader::load(parser, error);
+    if (!error.isEmpty()) {
+        std::cout << "ERROR: " << error.toStdString() << std::endl;
         return 1;
     }
-
-    // Specify single output file
-    QString outputFile = "D:/Dataset/OCR_DATA/Russian/Words/all_ocr_results_2.txt";
-    std::cout << "Output file path: " << outputFile.toStdString() << std::endl;
-
-    // Check if output directory exists
-    QFileInfo outputInfo(outputFile);
-    QDir outputDir = outputInfo.absoluteDir();
-    if (!outputDir.exists()) {
-        std::cout << "Creating output directory: " << outputDir.absolutePath().toStdString() << std::endl;
-        if (!outputDir.mkpath(".")) {
-            std::cout << "ERROR: Could not create output directory!" << std::endl;
-            return 1;
-        }
+    if (jobs.isEmpty()) {
+        std::cout << "ERROR: No jobs to run. Pass --input and --output, or --config." << std::endl;
+        parser.showHelp(1);
     }
 
-    qDebug() << "Starting OCR processing for folder:" << folderPath;
-    qDebug() << "Supported image formats:" << ocr.getSupportedExtensions().join(", ");
-
-    std::cout << "Starting OCR processing for folder: " << folderPath.toStdString() << std::endl;
-    std::cout << "Supported image formats: " << ocr.getSupportedExtensions().join(", ").toStdString() << std::endl;
+    // The OpenMP limit has to be in place before the first engine is created
+    bool explicitThreads = false;
+    int threadsPerEngine = 1;
+    for (const OcrJobSpec& job : jobs) {
+        explicitThreads = explicitThreads || job.threads != 1 || job.threadsPerEngine != 1;
+        threadsPerEngine = qMax(threadsPerEngine, job.threadsPerEngine);
+    }
+    if (explicitThreads) {
+        ThreadPlacement::limitOpenMpThreads(threadsPerEngine, argv);
+    }
 
-    // Process all images in the folder and save to single file
-    // Using English with confidence filtering
-    bool success = ocr.processFolder(folderPath, outputFile, "rus+ukr", true, 60,6);
+    OcrJobRunner runner;
+    int failedJobs = runner.run(jobs);
 
-    if (success) {
+    if (failedJobs == 0) {
         qDebug() << "\nOCR processing completed successfully!";
         std::cout << "\nOCR processing completed successfully!" << std::endl;
         return 0;
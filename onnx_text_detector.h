@@ -0,0 +1,254 @@
+#ifndef ONNX_TEXT_DETECTOR_H
+#define ONNX_TEXT_DETECTOR_H
+
+#include <QDebug>
+#include <QList>
+#include <QString>
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#ifdef HAVE_ONNXRUNTIME
+#include <onnxruntime_cxx_api.h>
+#endif
+
+// CPU text detector for DB-style (differentiable binarization) ONNX models.
+// The model takes a 1x3xHxW normalized image and returns a 1x1xHxW text
+// probability map; connected regions of that map become text boxes that can
+// be recognized one by one instead of running Tesseract's page layout analysis.
+class OnnxTextDetector {
+public:
+    OnnxTextDetector()
+        : binaryThreshold(0.3f), boxThreshold(0.6f), unclipRatio(1.5f),
+          maxSideLength(960), minBoxSize(3) {}
+
+    bool load(const QString& modelPath, int intraOpThreads = 1) {
+#ifdef HAVE_ONNXRUNTIME
+        try {
+            if (!env) {
+                env.reset(new Ort::Env(ORT_LOGGING_LEVEL_WARNING, "tes_cpp_text_detector"));
+            }
+
+            Ort::SessionOptions options;
+            options.SetIntraOpNumThreads(intraOpThreads);
+            options.SetInterOpNumThreads(1);
+            options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+
+#ifdef _WIN32
+            std::wstring path = modelPath.toStdWString();
+#else
+            std::string path = modelPath.toStdString();
+#endif
+            session.reset(new Ort::Session(*env, path.c_str(), options));
+
+            Ort::AllocatorWithDefaultOptions allocator;
+            inputName = session->GetInputNameAllocated(0, allocator).get();
+            outputName = session->GetOutputNameAllocated(0, allocator).get();
+        } catch (const Ort::Exception& e) {
+            qDebug() << "Could not load text detection model:" << modelPath << e.what();
+            std::cout << "ERROR: Could not load text detection model: " << modelPath.toStdString()
+                      << " (" << e.what() << ")" << std::endl;
+            session.reset();
+            return false;
+        }
+
+        std::cout << "Text detection model loaded: " << modelPath.toStdString() << std::endl;
+        return true;
+#else
+        Q_UNUSED(intraOpThreads);
+        qDebug() << "Built without ONNX Runtime, cannot load text detection model:" << modelPath;
+        std::cout << "ERROR: Built without ONNX Runtime, cannot load text detection model: "
+                  << modelPath.toStdString() << std::endl;
+        return false;
+#endif
+    }
+
+    bool isLoaded() const {
+#ifdef HAVE_ONNXRUNTIME
+        return session != nullptr;
+#else
+        return false;
+#endif
+    }
+
+    // Returns text regions in image coordinates, sorted in reading order
+    QList<cv::Rect> detect(const cv::Mat& image) {
+        QList<cv::Rect> regions;
+#ifdef HAVE_ONNXRUNTIME
+        if (!session || image.empty()) {
+            return regions;
+        }
+
+        cv::Mat bgr;
+        if (image.channels() == 1) {
+            cv::cvtColor(image, bgr, cv::COLOR_GRAY2BGR);
+        } else {
+            bgr = image;
+        }
+
+        // DB models need both sides to be multiples of 32
+        double scale = qMin(1.0, static_cast<double>(maxSideLength) / qMax(bgr.cols, bgr.rows));
+        int inputWidth = qMax(32, static_cast<int>(bgr.cols * scale + 16) / 32 * 32);
+        int inputHeight = qMax(32, static_cast<int>(bgr.rows * scale + 16) / 32 * 32);
+
+        cv::Mat resized;
+        cv::resize(bgr, resized, cv::Size(inputWidth, inputHeight));
+
+        std::vector<float> input = toNormalizedCHW(resized);
+        std::vector<int64_t> shape = {1, 3, inputHeight, inputWidth};
+
+        try {
+            Ort::MemoryInfo memoryInfo = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+            Ort::Value inputTensor = Ort::Value::CreateTensor<float>(memoryInfo, input.data(), input.size(),
+                                                                     shape.data(), shape.size());
+
+            const char* inputNames[] = {inputName.c_str()};
+            const char* outputNames[] = {outputName.c_str()};
+            std::vector<Ort::Value> outputs = session->Run(Ort::RunOptions{nullptr}, inputNames,
+                                                           &inputTensor, 1, outputNames, 1);
+
+            std::vector<int64_t> outputShape = outputs[0].GetTensorTypeAndShapeInfo().GetShape();
+            int mapHeight = static_cast<int>(outputShape[outputShape.size() - 2]);
+            int mapWidth = static_cast<int>(outputShape[outputShape.size() - 1]);
+            cv::Mat probability(mapHeight, mapWidth, CV_32F, outputs[0].GetTensorMutableData<float>());
+
+            regions = boxesFromProbabilityMap(probability,
+                                              static_cast<double>(image.cols) / mapWidth,
+                                              static_cast<double>(image.rows) / mapHeight,
+                                              cv::Rect(0, 0, image.cols, image.rows));
+        } catch (const Ort::Exception& e) {
+            qDebug() << "Text detection failed:" << e.what();
+            std::cout << "ERROR: Text detection failed: " << e.what() << std::endl;
+        }
+#else
+        Q_UNUSED(image);
+#endif
+        return regions;
+    }
+
+    void setBinaryThreshold(float threshold) {
+        binaryThreshold = threshold;
+    }
+
+    void setBoxThreshold(float threshold) {
+        boxThreshold = threshold;
+    }
+
+    void setUnclipRatio(float ratio) {
+        unclipRatio = ratio;
+    }
+
+    void setMaxSideLength(int pixels) {
+        maxSideLength = pixels;
+    }
+
+private:
+    static std::vector<float> toNormalizedCHW(const cv::Mat& bgr) {
+        // ImageNet mean/std, the normalization DB detectors are trained with
+        const float mean[3] = {0.485f, 0.456f, 0.406f};
+        const float stddev[3] = {0.229f, 0.224f, 0.225f};
+
+        const int planeSize = bgr.rows * bgr.cols;
+        std::vector<float> chw(3 * planeSize);
+
+        for (int y = 0; y < bgr.rows; y++) {
+            const cv::Vec3b* row = bgr.ptr<cv::Vec3b>(y);
+            for (int x = 0; x < bgr.cols; x++) {
+                for (int c = 0; c < 3; c++) {
+                    chw[c * planeSize + y * bgr.cols + x] = (row[x][c] / 255.0f - mean[c]) / stddev[c];
+                }
+            }
+        }
+        return chw;
+    }
+
+    QList<cv::Rect> boxesFromProbabilityMap(const cv::Mat& probability, double scaleX, double scaleY,
+                                            const cv::Rect& imageBounds) const {
+        cv::Mat binary = probability > binaryThreshold;
+
+        std::vector<std::vector<cv::Point>> contours;
+        cv::findContours(binary, contours, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE);
+
+        QList<cv::Rect> boxes;
+        for (const std::vector<cv::Point>& contour : contours) {
+            cv::Rect box = cv::boundingRect(contour);
+            if (box.width < minBoxSize || box.height < minBoxSize) {
+                continue;
+            }
+
+            // Score the region by its mean probability inside the contour
+            cv::Mat mask = cv::Mat::zeros(box.size(), CV_8U);
+            std::vector<std::vector<cv::Point>> shifted(1);
+            for (const cv::Point& p : contour) {
+                shifted[0].push_back(p - box.tl());
+            }
+            cv::fillPoly(mask, shifted, cv::Scalar(255));
+            if (cv::mean(probability(box), mask)[0] < boxThreshold) {
+                continue;
+            }
+
+            // The probability map shrinks text regions; grow them back (DB "unclip")
+            double perimeter = cv::arcLength(contour, true);
+            int distance = perimeter > 0
+                ? static_cast<int>(cv::contourArea(contour) * unclipRatio / perimeter + 0.5)
+                : 0;
+            box.x -= distance;
+            box.y -= distance;
+            box.width += 2 * distance;
+            box.height += 2 * distance;
+
+            cv::Rect scaled(static_cast<int>(box.x * scaleX), static_cast<int>(box.y * scaleY),
+                            static_cast<int>(box.width * scaleX + 0.5), static_cast<int>(box.height * scaleY + 0.5));
+            scaled &= imageBounds;
+            if (scaled.area() > 0) {
+                boxes.append(scaled);
+            }
+        }
+
+        return inReadingOrder(boxes);
+    }
+
+    // Top to bottom; boxes whose vertical centers fall within the current line
+    // are grouped together and ordered left to right.
+    static QList<cv::Rect> inReadingOrder(QList<cv::Rect> boxes) {
+        std::sort(boxes.begin(), boxes.end(), [](const cv::Rect& a, const cv::Rect& b) {
+            return a.y < b.y;
+        });
+
+        QList<cv::Rect> ordered;
+        int lineStart = 0;
+        while (lineStart < boxes.size()) {
+            int lineBottom = boxes[lineStart].y + boxes[lineStart].height;
+            int lineEnd = lineStart + 1;
+            while (lineEnd < boxes.size() && boxes[lineEnd].y + boxes[lineEnd].height / 2 < lineBottom) {
+                lineEnd++;
+            }
+
+            std::sort(boxes.begin() + lineStart, boxes.begin() + lineEnd, [](const cv::Rect& a, const cv::Rect& b) {
+                return a.x < b.x;
+            });
+            for (int i = lineStart; i < lineEnd; i++) {
+                ordered.append(boxes[i]);
+            }
+            lineStart = lineEnd;
+        }
+        return ordered;
+    }
+
+    float binaryThreshold;
+    float boxThreshold;
+    float unclipRatio;
+    int maxSideLength;
+    int minBoxSize;
+
+#ifdef HAVE_ONNXRUNTIME
+    std::unique_ptr<Ort::Env> env;
+    std::unique_ptr<Ort::Session> session;
+    std::string inputName;
+    std::string outputName;
+#endif
+};
+
+#endif // ONNX_TEXT_DETECTOR_H
@@ -0,0 +1,84 @@
+#ifndef RECOGNITION_DEADLINE_H
+#define RECOGNITION_DEADLINE_H
+
+#include <atomic>
+#include <tesseract/baseapi.h>
+#include <tesseract/ocrclass.h>
+
+// Time budget and cancel flag for recognizing one image, shared by
+// TesseractOCR and OcrService. Every Tesseract pass over the image runs under
+// the same monitor, so they all draw on one budget:
+//
+//   RecognitionDeadline deadline(&cancelRequested, imageTimeoutMs);
+//   if (deadline.recognize(engine) != RecognitionDeadline::Recognized) ...
+//   lineRecognizer->recognizeLines(crops, deadline.monitor());
+//
+// Tesseract polls the monitor between words; layout analysis does not poll
+// it, so an image can overrun the budget by the time its layout takes.
+class RecognitionDeadline {
+public:
+    enum Outcome {
+        Recognized,
+        TimedOut,
+        Cancelled,
+        Failed
+    };
+
+    // cancelFlag (not owned, may be null) aborts recognition once set;
+    // timeoutMs counts from construction (0 = no limit)
+    RecognitionDeadline(const std::atomic<bool>* cancelFlag, int timeoutMs) : cancelFlag(cancelFlag) {
+        desc.cancel = &RecognitionDeadline::cancelRecognition;
+        desc.cancel_this = this;
+        if (timeoutMs > 0) {
+            desc.set_deadline_msecs(timeoutMs);
+        }
+    }
+
+    RecognitionDeadline(const RecognitionDeadline&) = delete;
+    RecognitionDeadline& operator=(const RecognitionDeadline&) = delete;
+
+    // For the line recognizers and the line refiner
+    tesseract::ETEXT_DESC* monitor() {
+        return &desc;
+    }
+
+    bool cancelled() const {
+        return cancelFlag && *cancelFlag;
+    }
+
+    bool timedOut() const {
+        return desc.deadline_exceeded();
+    }
+
+    // For code that only holds the monitor: true once its deadline has
+    // passed or its cancel callback fires, as opposed to a plain failure
+    static bool stopRequested(tesseract::ETEXT_DESC* monitor) {
+        return monitor && (monitor->deadline_exceeded() ||
+                           (monitor->cancel && monitor->cancel(monitor->cancel_this, 0)));
+    }
+
+    // Runs layout analysis and recognition on the image set in engine. On any
+    // outcome but Recognized the partial results are dropped (the loaded
+    // model stays in place) so the next image can use the engine.
+    Outcome recognize(tesseract::TessBaseAPI* engine) {
+        if (engine->Recognize(&desc) == 0) {
+            return Recognized;
+        }
+
+        Outcome outcome = cancelled() ? Cancelled : timedOut() ? TimedOut : Failed;
+        engine->Clear();
+        return outcome;
+    }
+
+private:
+    // Tesseract cancel callback, polled between words
+    static bool cancelRecognition(void* cancelThis, int words) {
+        (void)words;
+        return static_cast<RecognitionDeadline*>(cancelThis)->cancelled();
+    }
+
+    tesseract::ETEXT_DESC desc;
+    const std::atomic<bool>* cancelFlag;
+};
+
+#endif // RECOGNITION_DEADLINE_H
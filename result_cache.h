@@ -0,0 +1,113 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QString>
+#include <deque>
+#include <iostream>
+
+// Reuses OCR results for byte-identical images. Keys combine the image
+// content hash with the settings that influence the result, so the same file
+// run with a different language or threshold is recognized again.
+// Optionally persisted as an append-only file ("key<TAB>base64 text" lines)
+// so later runs start warm. At most maxEntries results are kept in memory,
+// dropping the oldest first, so long watch runs do not grow without bound.
+class OcrResultCache {
+public:
+    explicit OcrResultCache(const QString& persistPath = QString(), int maxEntries = 20000)
+        : maxEntries(qMax(1, maxEntries)), hits(0), misses(0) {
+        if (!persistPath.isEmpty()) {
+            load(persistPath);
+            persistFile.setFileName(persistPath);
+            if (!persistFile.open(QIODevice::WriteOnly | QIODevice::Append)) {
+                qDebug() << "Could not open result cache file:" << persistPath;
+                std::cout << "ERROR: Could not open result cache file: " << persistPath.toStdString() << std::endl;
+            }
+        }
+    }
+
+    static QByteArray makeKey(const QByteArray& imageBytes, const QString& settings) {
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        hash.addData(imageBytes);
+        hash.addData(settings.toUtf8());
+        return hash.result().toHex();
+    }
+
+    bool lookup(const QByteArray& key, QString& text) {
+        QMutexLocker locker(&mutex);
+        if (!entries.contains(key)) {
+            misses++;
+            return false;
+        }
+        text = entries.value(key);
+        hits++;
+        return true;
+    }
+
+    void insert(const QByteArray& key, const QString& text) {
+        QMutexLocker locker(&mutex);
+        if (entries.contains(key)) {
+            return;
+        }
+        remember(key, text);
+
+        if (persistFile.isOpen()) {
+            persistFile.write(key + "\t" + text.toUtf8().toBase64() + "\n");
+            persistFile.flush();
+        }
+    }
+
+    int hitCount() const {
+        return hits;
+    }
+
+    int missCount() const {
+        return misses;
+    }
+
+private:
+    void load(const QString& path) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return;
+        }
+
+        while (!file.atEnd()) {
+            QByteArray line = file.readLine().trimmed();
+            int tab = line.indexOf('\t');
+            if (tab > 0) {
+                QByteArray key = line.left(tab);
+                if (!entries.contains(key)) {
+                    remember(key, QString::fromUtf8(QByteArray::fromBase64(line.mid(tab + 1))));
+                }
+            }
+        }
+
+        std::cout << "Loaded " << entries.size() << " cached results from: " << path.toStdString() << std::endl;
+    }
+
+    void remember(const QByteArray& key, const QString& text) {
+        entries.insert(key, text);
+        insertionOrder.push_back(key);
+        while (static_cast<int>(insertionOrder.size()) > maxEntries) {
+            entries.remove(insertionOrder.front());
+            insertionOrder.pop_front();
+        }
+    }
+
+    int maxEntries;
+    QHash<QByteArray, QString> entries;
+    std::deque<QByteArray> insertionOrder;
+    QFile persistFile;
+    QMutex mutex;
+    int hits;
+    int misses;
+};
+
+#endif // RESULT_CACHE_H
@@ -1,4 +1,4 @@
-QT += core widgets
+QT += core widgets network
 QT -= gui
 
 CONFIG += c++11 console
@@ -9,12 +9,29 @@ TARGET = tes_cpp
 
 SOURCES += on_folder.cpp
 
+HEADERS += tesseract_ocr.h \
+           ocr_service.h \
+           image_pipeline.h \
+           engine_pool.h \
+           line_refiner.h \
+           recognition_deadline.h \
+           onnx_text_detector.h \
+           ocr_recognizer.h \
+           thread_placement.h \
+           job_spec.h \
+           result_cache.h \
+           worker_process.h \
+           image_queue.h \
+           folder_watcher.h \
+           near_duplicate_index.h \
+           confidence_table.h \
+           corpus_analytics.h
+
 DEFINES += QT_DEPRECATED_WARNINGS
 
 # ====== INCLUDE PATHS ======
 INCLUDEPATH += "C:/Qt/Qt5.8.0/5.8/msvc2015_64/include"
 INCLUDEPATH += "C:/opencv_460/build/include"
-INCLUDEPATH += "C:/boost_1_67_0"
 INCLUDEPATH += "C:/json-develop/include"
 INCLUDEPATH += "C:/Program Files/temp"  # Tesseract headers
 INCLUDEPATH += "C:/microsoft.ml.onnxruntime.1.15.0/build/native/include"
@@ -45,19 +62,10 @@ win32 {
 #            -ltesseract55 \
 #            -lleptonica-1.85.0
 
-    # ---- Boost ----
-    CONFIG(debug, debug|release) {
-        LIBS += -L"C:/boost_1_67_0/lib64-msvc-14.0" \
-                -lboost_date_time-vc140-mt-gd-x64-1_67
-    }
-    CONFIG(release, debug|release) {
-        LIBS += -L"C:/boost_1_67_0/lib64-msvc-14.0" \
-                -lboost_date_time-vc140-mt-x64-1_67
-    }
-
     # ---- ONNX Runtime ----
     LIBS += -L"C:/microsoft.ml.onnxruntime.1.15.0/runtimes/win-x64/native" \
             -lonnxruntime
+    DEFINES += HAVE_ONNXRUNTIME
 
     # ---- Windows system libraries ----
     LIBS += -lws2_32 -luser32 -lgdi32 -lcomdlg32 -lole32
@@ -71,4 +79,5 @@ unix {
     ONNX_PATH = /usr/local/lib/onnxruntime
     INCLUDEPATH += $$ONNX_PATH/include
     LIBS += -L$$ONNX_PATH/lib -lonnxruntime
+    DEFINES += HAVE_ONNXRUNTIME
 }
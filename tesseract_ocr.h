@@ -0,0 +1,1109 @@
+#ifndef TESSERACT_OCR_H
+#define TESSERACT_OCR_H
+
+#include <QDebug>
+#include <QFile>
+#include <QTextStream>
+#include <QString>
+#include <QDir>
+#include <QStandardPaths>
+#include <QFileInfo>
+#include <QStringList>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QByteArray>
+#include <QMutex>
+#include <QMap>
+#include <QPair>
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include <tesseract/baseapi.h>
+#include <tesseract/ocrclass.h>
+#include <tesseract/resultiterator.h>
+#include <leptonica/allheaders.h>
+#include "engine_pool.h"
+#include "recognition_deadline.h"
+#include "ocr_recognizer.h"
+#include "image_pipeline.h"
+#include "thread_placement.h"
+#include "result_cache.h"
+#include "worker_process.h"
+#include "image_queue.h"
+#include "folder_watcher.h"
+#include "near_duplicate_index.h"
+#include "corpus_analytics.h"
+
+// OCR of image folders on pools of Tesseract engines, with the optional ONNX
+// front-ends, result caching and worker isolation. Shared by the tes_cpp
+// tool and anything else built on the tesseract_ocr library target.
+class TesseractOCR {
+public:
+    TesseractOCR() : pipeline(&cancelRequested) {
+        api = nullptr;
+        singleLineImages = false;
+        threadsPerEngine = 1;
+        engineMode = tesseract::OEM_LSTM_ONLY;
+        loadedEngineMode = engineMode;
+        workerPlacements = ThreadPlacement::plan(1);
+        pageSegMode = 6;
+        minFileSize = 0;
+        maxFileSize = 0;
+        cancelRequested = false;
+        processIsolation = false;
+        maxImageRetries = 1;
+        watchSettleMs = 500;
+
+        // Empty tessdata path: Tesseract uses TESSDATA_PREFIX or its built-in default
+        tessdataPath = QString();
+        pipeline.setModel(tessdataPath, engineMode);
+
+        // Supported image extensions
+        supportedExtensions << "*.png" << "*.jpg" << "*.jpeg"
+                           << "*.tiff" << "*.tif" << "*.bmp"
+                           << "*.gif" << "*.webp";
+    }
+
+    ~TesseractOCR() {
+        cleanup();
+    }
+
+    bool initialize(const QString& language = "eng",int pageSegmentationMode = 6) {
+        if (api && language == loadedLanguage && tessdataPath == loadedTessdataPath && engineMode == loadedEngineMode) {
+            // Same model already loaded: keep the warm engines and only switch settings
+            pageSegMode = pageSegmentationMode;
+            pipeline.setPageSettings(language, pageSegmentationMode);
+            resizeEnginePools();
+            if (api) {
+                api->SetPageSegMode(static_cast<tesseract::PageSegMode>(pageSegmentationMode));
+                std::cout << "Reusing initialized Tesseract engines for language: " << language.toStdString() << std::endl;
+                return true;
+            }
+        }
+
+        cleanup(); // Clean up any existing instance
+
+        // The page engine is worker 0's engine of the page pool and is handed
+        // back to worker 0 for parallel runs, so N workers hold N models, not N + 1
+        pageSegMode = pageSegmentationMode;
+        pagePool.reset(new TesseractEnginePool(tessdataPath, language, workerPlacements.size(), engineMode));
+        pagePoolCpus = placementCpus();
+        acquirePageEngine();
+
+        if (!api) {
+            qDebug() << "Could not initialize tesseract with language:" << language;
+            qDebug() << "Make sure tessdata path exists:" << tessdataPath;
+
+            // Check if tessdata path exists
+            QDir tessdataDir(tessdataPath);
+            if (tessdataPath.isEmpty()) {
+                std::cout << "ERROR: No model found in the default tessdata location; "
+                             "set TESSDATA_PREFIX or pass --tessdata" << std::endl;
+            } else if (!tessdataDir.exists()) {
+                qDebug() << "ERROR: tessdata directory does not exist!";
+                std::cout << "ERROR: tessdata directory does not exist: " << tessdataPath.toStdString() << std::endl;
+            }
+
+            pagePool.reset();
+            return false;
+        }
+
+        loadedLanguage = language;
+        loadedTessdataPath = tessdataPath;
+        loadedEngineMode = engineMode;
+        pipeline.setPageSettings(language, pageSegmentationMode);
+        resizeEnginePools();
+
+        qDebug() << "Tesseract initialized successfully with language:" << language;
+        std::cout << "Tesseract initialized successfully with language: " << language.toStdString() << std::endl;
+        return true;
+    }
+
+    void cleanup() {
+        pipeline.setLineEnginePool(nullptr);
+        linePool.reset();
+        pageLease.release();
+        api = nullptr;
+        pagePool.reset();
+        loadedLanguage.clear();
+    }
+
+
+    // timedOut (optional) is set when recognition hit the image timeout or was cancelled
+    QString processImage(const QString& imagePath, bool* timedOut = nullptr) {
+        if (!api) {
+            qDebug() << "Tesseract not initialized. Call initialize() first.";
+            std::cout << "ERROR: Tesseract not initialized!" << std::endl;
+            return QString();
+        }
+
+        return recognizeImage(api, imagePath, false, 0, timedOut);
+    }
+
+    QString processImageWithConfidence(const QString& imagePath, int minConfidence = 60, bool* timedOut = nullptr) {
+        if (!api) {
+            qDebug() << "Tesseract not initialized. Call initialize() first.";
+            std::cout << "ERROR: Tesseract not initialized!" << std::endl;
+            return QString();
+        }
+
+        return recognizeImage(api, imagePath, true, minConfidence, timedOut);
+    }
+
+    // Recognizes an encoded image (PNG, JPEG, ...) held in memory; label names it in the log
+    QString processImageData(const QByteArray& imageBytes, const QString& label,
+                             bool useConfidence, int minConfidence = 60, bool* timedOut = nullptr) {
+        if (!api) {
+            qDebug() << "Tesseract not initialized. Call initialize() first.";
+            std::cout << "ERROR: Tesseract not initialized!" << std::endl;
+            return QString();
+        }
+
+        return recognizeImageData(api, label, imageBytes, useConfidence, minConfidence, timedOut);
+    }
+
+    bool saveToFile(const QString& text, const QString& outputPath) {
+        QFile file(outputPath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            qDebug() << "Could not create output file:" << outputPath;
+            std::cout << "ERROR: Could not create output file: " << outputPath.toStdString() << std::endl;
+            return false;
+        }
+
+        QTextStream out(&file);
+        out.setCodec("UTF-8");
+        out << text;
+        file.close();
+
+        qDebug() << "Text saved to:" << outputPath;
+        std::cout << "Text saved to: " << outputPath.toStdString() << std::endl;
+        return true;
+    }
+
+    bool processFolder(const QString& folderPath, const QString& outputFile,
+                      const QString& language = "rus+ukr", bool useConfidence = false, int minConfidence = 60,int pageSegmentationMode = 6) {
+
+        std::cout << "Starting processFolder with:" << std::endl;
+        std::cout << "  Folder: " << folderPath.toStdString() << std::endl;
+        std::cout << "  Output: " << outputFile.toStdString() << std::endl;
+        std::cout << "  Language: " << language.toStdString() << std::endl;
+
+        // Isolated workers load their own engines
+        bool isolated = processIsolation && !singleLineImages;
+        if (!isolated && !initialize(language,pageSegmentationMode)) {
+            std::cout << "ERROR: Failed to initialize Tesseract!" << std::endl;
+            return false;
+        }
+
+        QDir inputDir(folderPath);
+        if (!inputDir.exists()) {
+            qDebug() << "Input folder does not exist:" << folderPath;
+            std::cout << "ERROR: Input folder does not exist: " << folderPath.toStdString() << std::endl;
+            return false;
+        }
+
+        std::cout << "Input folder exists and is accessible." << std::endl;
+
+        // Get all image files in the folder
+        QStringList imageFiles;
+        QStringList patterns = nameFilters.isEmpty() ? supportedExtensions : nameFilters;
+        for (const QString& extension : patterns) {
+            QStringList matchingFiles = inputDir.entryList(QStringList() << extension, QDir::Files);
+            imageFiles.append(matchingFiles);
+            std::cout << "Found " << matchingFiles.count() << " files matching "
+                      << extension.toStdString() << std::endl;
+        }
+
+        if (minFileSize > 0 || maxFileSize > 0) {
+            QStringList sizeFiltered;
+            for (const QString& fileName : imageFiles) {
+                qint64 size = QFileInfo(inputDir, fileName).size();
+                if (size >= minFileSize && (maxFileSize <= 0 || size <= maxFileSize)) {
+                    sizeFiltered << fileName;
+                }
+            }
+            std::cout << "Size filter kept " << sizeFiltered.count() << " of "
+                      << imageFiles.count() << " files" << std::endl;
+            imageFiles = sizeFiltered;
+        }
+
+        if (imageFiles.isEmpty()) {
+            qDebug() << "No image files found in folder:" << folderPath;
+            std::cout << "ERROR: No image files found in folder: " << folderPath.toStdString() << std::endl;
+
+            // List all files in directory for debugging
+            QStringList allFiles = inputDir.entryList(QDir::Files);
+            std::cout << "All files in directory:" << std::endl;
+            for (const QString& file : allFiles) {
+                std::cout << "  " << file.toStdString() << std::endl;
+            }
+
+            return false;
+        }
+
+        qDebug() << "Found" << imageFiles.count() << "image files to process";
+        std::cout << "Found " << imageFiles.count() << " image files to process" << std::endl;
+
+        // Create/open the single output file
+        QFile file(outputFile);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            qDebug() << "Could not create output file:" << outputFile;
+            std::cout << "ERROR: Could not create output file: " << outputFile.toStdString() << std::endl;
+            return false;
+        }
+
+        std::cout << "Output file created successfully." << std::endl;
+
+        QTextStream out(&file);
+        out.setCodec("UTF-8");
+
+        FolderRunStats stats;
+
+        // Write header to the file
+        out << "OCR Results for folder: " << folderPath << "\n";
+        out << "Generated on: " << QDateTime::currentDateTime().toString() << "\n";
+        out << "Language: " << language << "\n";
+        out << "Total images: " << imageFiles.count() << "\n";
+        if (useConfidence) {
+            out << "Minimum confidence: " << minConfidence << "%\n";
+        }
+        out << QString("=").repeated(80) << "\n\n";
+
+        // Writes one file's result to the output and updates the counters
+        auto writeResult = [&](const QString& fileName, const QString& ocrResult, ImageOutcome outcome) {
+            writeResultEntry(out, stats, inputDir, fileName, ocrResult, outcome, useConfidence);
+        };
+
+        if (isolated || (workerPlacements.size() > 1 && !singleLineImages)) {
+            const bool inQueueOrder = true;
+            ImageQueue queue;
+            queue.push(imageFiles);
+            queue.close();
+            if (isolated) {
+                processFilesInWorkers(inputDir, queue, language, pageSegmentationMode,
+                                      useConfidence, minConfidence, writeResult, inQueueOrder);
+            } else {
+                processFilesInParallel(inputDir, queue, language, pageSegmentationMode,
+                                       useConfidence, minConfidence, writeResult, inQueueOrder);
+            }
+        } else {
+            // Single-line crops are recognized in batches by the line recognizer
+            int batchSize = singleLineImages ? pipeline.lineRecognizer()->preferredBatchSize() : 1;
+
+            for (int batchStart = 0; batchStart < imageFiles.count(); batchStart += batchSize) {
+                QStringList batchFiles = imageFiles.mid(batchStart, batchSize);
+                QStringList batchResults;
+                QList<bool> batchTimedOut;
+                if (singleLineImages) {
+                    QStringList batchPaths;
+                    for (const QString& fileName : batchFiles) {
+                        batchPaths << inputDir.absoluteFilePath(fileName);
+                    }
+                    batchResults = processLineImages(batchPaths, useConfidence ? minConfidence : 0, &batchTimedOut);
+                }
+
+                // Process each image file
+                for (int batchIndex = 0; batchIndex < batchFiles.count(); batchIndex++) {
+                    const QString& fileName = batchFiles[batchIndex];
+                    QString fullImagePath = inputDir.absoluteFilePath(fileName);
+
+                    qDebug() << "\n--- Processing:" << fileName << "---";
+                    std::cout << "\n--- Processing: " << fileName.toStdString() << " ---" << std::endl;
+
+                    QString ocrResult;
+                    bool timedOut = false;
+                    if (singleLineImages) {
+                        ocrResult = batchResults[batchIndex];
+                        timedOut = batchTimedOut[batchIndex];
+                    } else if (useConfidence) {
+                        ocrResult = processImageWithConfidence(fullImagePath, minConfidence, &timedOut);
+                    } else {
+                        ocrResult = processImage(fullImagePath, &timedOut);
+                    }
+
+                    writeResult(fileName, ocrResult, timedOut ? ImageTimedOut : ImageProcessed);
+                }
+            }
+        }
+
+        // Write summary at the end of file
+        writeSummary(out, stats, imageFiles.count());
+        file.close();
+
+        writeQuarantineList(outputFile, stats, false);
+        writeNearDuplicateReport(outputFile, false);
+        printSummary(stats, imageFiles.count(), outputFile);
+
+        return stats.successCount > 0;
+    }
+
+    // Watch mode: recognizes images as they are completed in folderPath and
+    // appends each result to outputFile as soon as it is ready. Files already
+    // in the folder are left alone (run processFolder once for those). Runs
+    // until requestCancel() or until no new file arrived for idleExitSeconds
+    // (0 = keep watching).
+    bool watchFolder(const QString& folderPath, const QString& outputFile, const QString& language = "rus+ukr",
+                     bool useConfidence = false, int minConfidence = 60, int pageSegmentationMode = 6,
+                     int idleExitSeconds = 0) {
+        if (singleLineImages) {
+            std::cout << "ERROR: Watch mode does not support single-line images" << std::endl;
+            return false;
+        }
+
+        std::cout << "Starting watchFolder with:" << std::endl;
+        std::cout << "  Folder: " << folderPath.toStdString() << std::endl;
+        std::cout << "  Output: " << outputFile.toStdString() << std::endl;
+        std::cout << "  Language: " << language.toStdString() << std::endl;
+
+        if (!processIsolation && !initialize(language, pageSegmentationMode)) {
+            std::cout << "ERROR: Failed to initialize Tesseract!" << std::endl;
+            return false;
+        }
+
+        QDir inputDir(folderPath);
+        FolderWatcher watcher(folderPath, nameFilters.isEmpty() ? supportedExtensions : nameFilters, watchSettleMs);
+        if (!watcher.start()) {
+            return false;
+        }
+
+        // Results are appended, so a restarted watch continues the same file
+        QFile file(outputFile);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+            qDebug() << "Could not open output file:" << outputFile;
+            std::cout << "ERROR: Could not open output file: " << outputFile.toStdString() << std::endl;
+            return false;
+        }
+
+        QTextStream out(&file);
+        out.setCodec("UTF-8");
+        out << "OCR Results for watched folder: " << folderPath << "\n";
+        out << "Watching since: " << QDateTime::currentDateTime().toString() << "\n";
+        out << "Language: " << language << "\n";
+        if (useConfidence) {
+            out << "Minimum confidence: " << minConfidence << "%\n";
+        }
+        out << QString("=").repeated(80) << "\n\n";
+        out.flush();
+
+        FolderRunStats stats;
+        auto writeResult = [&](const QString& fileName, const QString& ocrResult, ImageOutcome outcome) {
+            writeResultEntry(out, stats, inputDir, fileName, ocrResult, outcome, useConfidence);
+        };
+
+        // Workers take files from the queue while this thread keeps watching.
+        // Results are appended as they finish, so a slow image holds back no other.
+        const bool inQueueOrder = false;
+        ImageQueue queue;
+        std::thread dispatcher([&]() {
+            if (processIsolation) {
+                processFilesInWorkers(inputDir, queue, language, pageSegmentationMode,
+                                      useConfidence, minConfidence, writeResult, inQueueOrder);
+            } else {
+                processFilesInParallel(inputDir, queue, language, pageSegmentationMode,
+                                       useConfidence, minConfidence, writeResult, inQueueOrder);
+            }
+        });
+
+        QElapsedTimer idle;
+        idle.start();
+        QElapsedTimer sinceReports;
+        sinceReports.start();
+        while (!cancelRequested) {
+            QStringList completed = watcher.waitForFiles(1000);
+            for (const QString& fileName : completed) {
+                qint64 size = QFileInfo(inputDir, fileName).size();
+                if (size < minFileSize || (maxFileSize > 0 && size > maxFileSize)) {
+                    std::cout << "Skipping (size filter): " << fileName.toStdString() << std::endl;
+                    continue;
+                }
+                std::cout << "Queued new image: " << fileName.toStdString() << std::endl;
+                queue.push(fileName);
+            }
+
+            if (!completed.isEmpty()) {
+                idle.restart();
+            }
+            if (completed.isEmpty() || sinceReports.elapsed() >= 60000) {
+                // Quiet moment (or a busy minute): bring the reports up to date
+                if (pipeline.getCorpusAnalytics()) {
+                    pipeline.getCorpusAnalytics()->saveReport();
+                }
+                writeNearDuplicateReport(outputFile, true);
+                sinceReports.restart();
+            }
+            if (completed.isEmpty() && idleExitSeconds > 0 && idle.elapsed() >= idleExitSeconds * 1000LL) {
+                std::cout << "No new images for " << idleExitSeconds << " s, stopping watch" << std::endl;
+                break;
+            }
+        }
+
+        queue.close();
+        dispatcher.join();
+
+        writeSummary(out, stats, queue.size());
+        file.close();
+
+        writeQuarantineList(outputFile, stats, true);
+        writeNearDuplicateReport(outputFile, true);
+        printSummary(stats, queue.size(), outputFile);
+        return true;
+    }
+
+    void setTessdataPath(const QString& path) {
+        tessdataPath = path;
+        pipeline.setModel(tessdataPath, engineMode);
+    }
+
+    QStringList getSupportedExtensions() const {
+        return supportedExtensions;
+    }
+
+    void setRefineLowConfidenceLines(bool enabled) {
+        pipeline.setRefineLowConfidenceLines(enabled);
+    }
+
+    // Total thread budget for processFolder. With more than one worker each
+    // worker is pinned to its own cores and owns one engine; threadsPerEngine
+    // must match the OpenMP limit applied at startup (see ThreadPlacement).
+    void setThreadBudget(int totalThreads, int threadsPerEngine = 1, const QString& cpuList = QString()) {
+        this->threadsPerEngine = qMax(1, threadsPerEngine);
+        workerPlacements = ThreadPlacement::plan(totalThreads, this->threadsPerEngine, cpuList);
+
+        std::cout << "Thread budget: " << workerPlacements.size() << " workers x "
+                  << this->threadsPerEngine << " threads per engine" << std::endl;
+        for (int w = 0; w < workerPlacements.size(); w++) {
+            QStringList cpus;
+            for (int cpu : workerPlacements[w].cpus) {
+                cpus << QString::number(cpu);
+            }
+            std::cout << "  Worker " << w << ": node " << workerPlacements[w].node
+                      << ", CPUs " << cpus.join(",").toStdString() << std::endl;
+        }
+    }
+
+    // Restricts processFolder to files matching these patterns (default: all
+    // supported extensions) and to the given size range (0 = no limit)
+    void setFileFilters(const QStringList& patterns, qint64 minBytes = 0, qint64 maxBytes = 0) {
+        nameFilters = patterns;
+        minFileSize = minBytes;
+        maxFileSize = maxBytes;
+    }
+
+    // Results for byte-identical images are taken from this cache (not owned; nullptr disables)
+    void setResultCache(OcrResultCache* cache) {
+        pipeline.setResultCache(cache);
+    }
+
+    // Adds every image recognized on a page engine to analytics (nullptr =
+    // off). The analytics are not owned and may be shared between instances.
+    void setCorpusAnalytics(CorpusAnalytics* analytics) {
+        pipeline.setCorpusAnalytics(analytics);
+    }
+
+    // Reuses the result of an earlier image whose perceptual hash ("dhash" or
+    // "phash") differs in at most maxDistance bits; a negative distance turns
+    // this off. With reportMatches, matches are listed in
+    // <output>.duplicates.txt; worker processes have no report to write to.
+    void setNearDuplicateDetection(int maxDistance, const QString& hashType = "dhash", bool reportMatches = true) {
+        pipeline.setNearDuplicateDetection(maxDistance, hashType, reportMatches);
+    }
+
+    // How long a new file must go unwritten before watchFolder picks it up
+    void setWatchSettleTime(int msecs) {
+        watchSettleMs = qMax(0, msecs);
+    }
+
+    // Abandons recognition of any single page image after msecs (0 = no limit).
+    // The limit covers page recognition, line refinement and line recognition
+    // of detected regions or single-line images; layout analysis and text
+    // detection cannot be interrupted. The engine is cleared and reused for
+    // the next image.
+    void setImageTimeout(int msecs) {
+        pipeline.setImageTimeout(msecs);
+    }
+
+    // Aborts the images currently being recognized and every later one until
+    // clearCancel(); safe to call from another thread
+    void requestCancel() {
+        cancelRequested = true;
+    }
+
+    void clearCancel() {
+        cancelRequested = false;
+    }
+
+    // Runs processFolder on separate worker processes instead of threads, one
+    // per worker of the thread budget. Each worker is this executable started
+    // with workerArguments (see OcrJobSpecLoader::workerArguments) and keeps
+    // its engine loaded. A worker that crashes or hangs is restarted and the
+    // image retried up to maxRetries times before it is quarantined. A worker
+    // counts as hung after twice the image timeout plus 30 s, or after 5
+    // minutes on one image when there is no image timeout.
+    void setProcessIsolation(bool enabled, const QStringList& workerArguments = QStringList(), int maxRetries = 1) {
+        processIsolation = enabled;
+        this->workerArguments = workerArguments;
+        maxImageRetries = qMax(0, maxRetries);
+    }
+
+    // OEM_LSTM_ONLY (default) skips loading the legacy classifier in every
+    // engine; OEM_DEFAULT restores Tesseract's own choice
+    void setEngineMode(tesseract::OcrEngineMode mode) {
+        engineMode = mode;
+        pipeline.setModel(tessdataPath, engineMode);
+    }
+
+    // Optional ONNX text detector; when loaded, only the detected regions are
+    // sent to Tesseract and its page layout analysis is skipped. An empty path
+    // removes the detector.
+    bool setTextDetectorModel(const QString& modelPath, int intraOpThreads = 1) {
+        return pipeline.setTextDetectorModel(modelPath, intraOpThreads);
+    }
+
+    // Optional CRNN/SVTR line recognizer; selected with setRecognizerBackend("onnx")
+    bool setOnnxLineRecognizer(const QString& modelPath, const QString& dictionaryPath,
+                               int intraOpThreads = 1, int batchSize = 16) {
+        return pipeline.setOnnxLineRecognizer(modelPath, dictionaryPath, intraOpThreads, batchSize);
+    }
+
+    // "tesseract" or "onnx"; used for detected regions and single-line images
+    bool setRecognizerBackend(const QString& backend) {
+        return pipeline.setRecognizerBackend(backend);
+    }
+
+    // Treat every input image as one text line crop: no layout analysis, and
+    // processFolder hands the images to the line recognizer in batches
+    void setSingleLineImages(bool enabled) {
+        singleLineImages = enabled;
+    }
+
+    // Recognizes each image as a single text line in one batch. Entries for
+    // images that fail to load, have no text or fall below minConfidence are
+    // empty. The batch gets the image timeout once per image; timedOut
+    // (optional) flags the images left unrecognized when it ran out or the
+    // run was cancelled.
+    QStringList processLineImages(const QStringList& imagePaths, int minConfidence = 0,
+                                  QList<bool>* timedOut = nullptr) {
+        QStringList results;
+        if (timedOut) {
+            timedOut->clear();
+        }
+        QList<cv::Mat> lines;
+        QList<int> lineIndices;
+
+        for (int i = 0; i < imagePaths.count(); i++) {
+            results << QString();
+            if (timedOut) {
+                timedOut->append(false);
+            }
+
+            cv::Mat image = cv::imread(imagePaths[i].toStdString());
+            if (image.empty()) {
+                qDebug() << "Could not load image:" << imagePaths[i];
+                std::cout << "ERROR: Could not load image: " << imagePaths[i].toStdString() << std::endl;
+                continue;
+            }
+            lines << image;
+            lineIndices << i;
+        }
+
+        OcrRecognizer* recognizer = pipeline.lineRecognizer();
+        RecognitionDeadline deadline(&cancelRequested, pipeline.getImageTimeout() * lines.size());
+        QList<RecognizedLine> recognized = recognizer->recognizeLines(lines, deadline.monitor());
+        for (int i = 0; i < recognized.size(); i++) {
+            const RecognizedLine& line = recognized[i];
+            if (line.abandoned) {
+                pipeline.reportAbandoned(imagePaths[lineIndices[i]], pipeline.getImageTimeout());
+                if (timedOut) {
+                    (*timedOut)[lineIndices[i]] = true;
+                }
+                continue;
+            }
+            std::cout << "OCR confidence for " << QFileInfo(imagePaths[lineIndices[i]]).fileName().toStdString()
+                      << ": " << line.confidence << "% (" << recognizer->name().toStdString() << ")" << std::endl;
+            if (line.confidence >= minConfidence) {
+                results[lineIndices[i]] = line.text;
+            }
+        }
+
+        return results;
+    }
+
+private:
+    enum ImageOutcome {
+        ImageProcessed,
+        ImageTimedOut,
+        ImageQuarantined,
+        ImageWorkerFailed       // No worker could take the image; says nothing about the image
+    };
+
+    struct FolderRunStats {
+        int successCount = 0;
+        int failCount = 0;
+        int timeoutCount = 0;
+        int workerFailureCount = 0;
+        QStringList quarantinedFiles;
+    };
+
+    typedef std::function<void(const QString&, const QString&, ImageOutcome)> ResultWriter;
+
+    // Passes results from the worker threads on to writeResult, either in
+    // queue order (results that finish early wait for the ones before them) or
+    // as they finish; add() may be called from any worker thread
+    class OrderedResults {
+    public:
+        OrderedResults(const ResultWriter& writeResult, bool inQueueOrder)
+            : writeResult(writeResult), inQueueOrder(inQueueOrder), nextToWrite(0) {}
+
+        void add(int index, const QString& fileName, const QString& ocrResult, ImageOutcome outcome) {
+            QMutexLocker locker(&mutex);
+            if (!inQueueOrder) {
+                writeResult(fileName, ocrResult, outcome);
+                return;
+            }
+
+            FinishedImage image;
+            image.fileName = fileName;
+            image.ocrResult = ocrResult;
+            image.outcome = outcome;
+            finished.insert(index, image);
+            while (finished.contains(nextToWrite)) {
+                FinishedImage next = finished.take(nextToWrite);
+                writeResult(next.fileName, next.ocrResult, next.outcome);
+                nextToWrite++;
+            }
+        }
+
+    private:
+        struct FinishedImage {
+            QString fileName;
+            QString ocrResult;
+            ImageOutcome outcome;
+        };
+
+        const ResultWriter& writeResult;
+        bool inQueueOrder;
+        QMap<int, FinishedImage> finished;
+        QMutex mutex;
+        int nextToWrite;
+    };
+
+    // Writes one file's result to the output and updates the counters
+    void writeResultEntry(QTextStream& out, FolderRunStats& stats, const QDir& inputDir, const QString& fileName,
+                          const QString& ocrResult, ImageOutcome outcome, bool useConfidence) {
+        if (outcome == ImageQuarantined) {
+            out << "File: " << fileName << "\n";
+            out << QString("-").repeated(40) << "\n";
+            out << "[OCR FAILED - Image repeatedly crashed the OCR worker, quarantined]\n\n";
+            out << QString("=").repeated(80) << "\n\n";
+
+            qDebug() << "✗ Quarantined:" << fileName;
+            std::cout << "✗ Quarantined: " << fileName.toStdString() << std::endl;
+            stats.failCount++;
+            stats.quarantinedFiles << inputDir.absoluteFilePath(fileName);
+        } else if (outcome == ImageTimedOut) {
+            out << "File: " << fileName << "\n";
+            out << QString("-").repeated(40) << "\n";
+            out << "[OCR TIMED OUT - Recognition took longer than " << pipeline.getImageTimeout() << " ms]\n\n";
+            out << QString("=").repeated(80) << "\n\n";
+
+            qDebug() << "✗ OCR timed out for:" << fileName;
+            std::cout << "✗ OCR timed out for: " << fileName.toStdString() << std::endl;
+            stats.failCount++;
+            stats.timeoutCount++;
+        } else if (outcome == ImageWorkerFailed) {
+            out << "File: " << fileName << "\n";
+            out << QString("-").repeated(40) << "\n";
+            out << "[OCR FAILED - No OCR worker available or the image could not be passed to it]\n\n";
+            out << QString("=").repeated(80) << "\n\n";
+
+            qDebug() << "✗ OCR worker unavailable for:" << fileName;
+            std::cout << "✗ OCR worker unavailable for: " << fileName.toStdString() << std::endl;
+            stats.failCount++;
+            stats.workerFailureCount++;
+        } else if (!ocrResult.isEmpty()) {
+            // Write to single file with filename header
+            out << "File: " << fileName << "\n";
+            out << QString("-").repeated(40) << "\n";
+            out << ocrResult.trimmed() << "\n\n";
+            out << QString("=").repeated(80) << "\n\n";
+
+            qDebug() << "✓ Successfully processed:" << fileName;
+            std::cout << "✓ Successfully processed: " << fileName.toStdString() << std::endl;
+            stats.successCount++;
+        } else {
+            // Write failure notice to file
+            out << "File: " << fileName << "\n";
+            out << QString("-").repeated(40) << "\n";
+            if (useConfidence) {
+                out << "[OCR FAILED - Low confidence or no text detected]\n\n";
+            } else {
+                out << "[OCR FAILED - No text detected]\n\n";
+            }
+            out << QString("=").repeated(80) << "\n\n";
+
+            qDebug() << "✗ OCR failed for:" << fileName;
+            std::cout << "✗ OCR failed for: " << fileName.toStdString() << std::endl;
+            stats.failCount++;
+        }
+
+        // Flush the output periodically
+        out.flush();
+    }
+
+    void writeSummary(QTextStream& out, const FolderRunStats& stats, int totalFiles) {
+        out << "\n" << QString("=").repeated(80) << "\n";
+        out << "PROCESSING SUMMARY\n";
+        out << QString("=").repeated(80) << "\n";
+        out << "Successfully processed: " << stats.successCount << " files\n";
+        out << "Failed: " << stats.failCount << " files\n";
+        if (stats.timeoutCount > 0) {
+            out << "Timed out: " << stats.timeoutCount << " files\n";
+        }
+        if (stats.workerFailureCount > 0) {
+            out << "Worker unavailable: " << stats.workerFailureCount << " files\n";
+        }
+        if (!stats.quarantinedFiles.isEmpty()) {
+            out << "Quarantined: " << stats.quarantinedFiles.count() << " files\n";
+        }
+        out << "Total files: " << totalFiles << "\n";
+    }
+
+    void printSummary(const FolderRunStats& stats, int totalFiles, const QString& outputFile) {
+        qDebug() << "\n=== Processing Complete ===";
+        qDebug() << "Successfully processed:" << stats.successCount << "files";
+        qDebug() << "Failed:" << stats.failCount << "files";
+        qDebug() << "Total files:" << totalFiles;
+        qDebug() << "All results saved to:" << outputFile;
+
+        std::cout << "\n=== Processing Complete ===" << std::endl;
+        std::cout << "Successfully processed: " << stats.successCount << " files" << std::endl;
+        std::cout << "Failed: " << stats.failCount << " files" << std::endl;
+        if (stats.timeoutCount > 0) {
+            std::cout << "Timed out: " << stats.timeoutCount << " files" << std::endl;
+        }
+        if (stats.workerFailureCount > 0) {
+            std::cout << "Worker unavailable: " << stats.workerFailureCount << " files" << std::endl;
+        }
+        if (!stats.quarantinedFiles.isEmpty()) {
+            std::cout << "Quarantined: " << stats.quarantinedFiles.count() << " files" << std::endl;
+        }
+        std::cout << "Total files: " << totalFiles << std::endl;
+        std::cout << "All results saved to: " << outputFile.toStdString() << std::endl;
+    }
+
+    // "image<TAB>reused result of<TAB>hash distance" per near-duplicate found in this run
+    void writeNearDuplicateReport(const QString& outputFile, bool append) {
+        NearDuplicateIndex* nearDuplicates = pipeline.getNearDuplicateIndex();
+        if (!nearDuplicates) {
+            return;
+        }
+        QList<NearDuplicateMatch> matches = nearDuplicates->takeMatches();
+        if (matches.isEmpty()) {
+            return;
+        }
+
+        QFile reportFile(outputFile + ".duplicates.txt");
+        QIODevice::OpenMode mode = QIODevice::WriteOnly | QIODevice::Text;
+        if (append) {
+            mode |= QIODevice::Append;
+        }
+        if (!reportFile.open(mode)) {
+            qDebug() << "Could not create near-duplicate report:" << reportFile.fileName();
+            return;
+        }
+
+        QTextStream report(&reportFile);
+        report.setCodec("UTF-8");
+        for (const NearDuplicateMatch& match : matches) {
+            report << match.imagePath << "\t" << match.originalPath << "\t" << match.distance << "\n";
+        }
+        reportFile.close();
+
+        std::cout << "Near-duplicates reused: " << matches.size() << " (listed in "
+                  << reportFile.fileName().toStdString() << ")" << std::endl;
+    }
+
+    // One path per line, so the images can be moved aside or inspected
+    void writeQuarantineList(const QString& outputFile, const FolderRunStats& stats, bool append) {
+        if (stats.quarantinedFiles.isEmpty()) {
+            return;
+        }
+
+        QFile quarantineFile(outputFile + ".quarantine.txt");
+        QIODevice::OpenMode mode = QIODevice::WriteOnly | QIODevice::Text;
+        if (append) {
+            mode |= QIODevice::Append;
+        }
+        if (quarantineFile.open(mode)) {
+            quarantineFile.write(stats.quarantinedFiles.join("\n").toUtf8() + "\n");
+            quarantineFile.close();
+            std::cout << "Quarantined images listed in: " << quarantineFile.fileName().toStdString() << std::endl;
+        }
+    }
+
+    // Takes worker 0's engine from the page pool as the page engine. The
+    // lease is taken on a thread pinned to worker 0's CPUs, so that on first
+    // use the model is loaded on the NUMA node worker 0 will run on.
+    void acquirePageEngine() {
+        QList<int> cpus = workerPlacements.isEmpty() ? QList<int>() : workerPlacements.first().cpus;
+        std::thread loader([&]() {
+            if (!cpus.isEmpty() && !ThreadPlacement::pinCurrentThread(cpus)) {
+                qDebug() << "Could not pin page engine thread to CPUs" << cpus;
+            }
+            pageLease = pagePool->acquireSlot(pageSegMode, 0);
+        });
+        loader.join();
+        api = pageLease.engine();
+    }
+
+    QList<QList<int>> placementCpus() const {
+        QList<QList<int>> cpus;
+        for (const WorkerPlacement& placement : workerPlacements) {
+            cpus.append(placement.cpus);
+        }
+        return cpus;
+    }
+
+    // (Re)creates the engine pools when the worker count changed. The page
+    // pool is also recreated when the workers moved to other CPUs, since its
+    // engines were loaded on the old workers' nodes.
+    void resizeEnginePools() {
+        int workers = workerPlacements.size();
+
+        // Engines for recognizing detected regions or line crops (created on first use)
+        if (!linePool || linePool->getMaxEngines() != workers) {
+            pipeline.setLineEnginePool(nullptr);
+            linePool.reset(new TesseractEnginePool(tessdataPath, loadedLanguage, workers, engineMode));
+            pipeline.setLineEnginePool(linePool.get());
+        }
+
+        // The page engine goes back before its pool is replaced
+        if (pagePool && (pagePool->getMaxEngines() != workers || pagePoolCpus != placementCpus())) {
+            pageLease.release();
+            api = nullptr;
+            pagePool.reset(new TesseractEnginePool(tessdataPath, loadedLanguage, workers, engineMode));
+            pagePoolCpus = placementCpus();
+            acquirePageEngine();
+        }
+    }
+
+    // Recognizes one image on the given engine through the shared pipeline
+    // (see OcrImagePipeline). With useConfidence, results below minConfidence
+    // (after line refinement) are dropped.
+    QString recognizeImage(tesseract::TessBaseAPI* engine, const QString& imagePath,
+                           bool useConfidence, int minConfidence, bool* timedOut = nullptr) {
+        if (timedOut) {
+            *timedOut = false;
+        }
+
+        QByteArray imageBytes;
+        if (!OcrImagePipeline::readImageFile(imagePath, imageBytes)) {
+            return QString();
+        }
+
+        return recognizeImageData(engine, imagePath, imageBytes, useConfidence, minConfidence, timedOut);
+    }
+
+    QString recognizeImageData(tesseract::TessBaseAPI* engine, const QString& imagePath, QByteArray imageBytes,
+                               bool useConfidence, int minConfidence, bool* timedOut) {
+        ImageRecognition recognition = pipeline.recognize(engine, imagePath, std::move(imageBytes),
+                                                          useConfidence, minConfidence);
+        if (timedOut) {
+            *timedOut = recognition.abandoned();
+        }
+        return recognition.text;
+    }
+
+    // Runs the queued files on pinned worker threads, one engine per worker,
+    // and hands results to writeResult as soon as they are ready, in queue
+    // order or in the order they finish. Returns once the queue is closed and drained.
+    void processFilesInParallel(const QDir& inputDir, ImageQueue& queue, const QString& language,
+                                int pageSegmentationMode, bool useConfidence, int minConfidence,
+                                const ResultWriter& writeResult, bool inQueueOrder) {
+        std::cout << "Processing in parallel with " << workerPlacements.size() << " workers" << std::endl;
+
+        // Each worker takes the engine bound to its placement, after pinning:
+        // an engine is created (first touched) on its worker's NUMA node and
+        // always goes back to that worker. The page engine is worker 0's
+        // engine, and the pool outlives the call so later folders reuse the
+        // warm engines on the same nodes.
+        resizeEnginePools();
+        pageLease.release();
+        api = nullptr;
+
+        OrderedResults results(writeResult, inQueueOrder);
+
+        std::vector<std::thread> workers;
+        for (int w = 0; w < workerPlacements.size(); w++) {
+            const WorkerPlacement placement = workerPlacements[w];
+            workers.emplace_back([&, w, placement]() {
+                if (!ThreadPlacement::pinCurrentThread(placement.cpus)) {
+                    qDebug() << "Could not pin worker thread to CPUs" << placement.cpus;
+                }
+
+                TesseractEnginePool::EngineLease lease = pagePool->acquireSlot(pageSegmentationMode, w);
+
+                int index = 0;
+                QString fileName;
+                while (queue.take(index, fileName)) {
+                    QString fullImagePath = inputDir.absoluteFilePath(fileName);
+                    std::cout << "\n--- Processing: " << fileName.toStdString() << " ---" << std::endl;
+
+                    QString ocrResult;
+                    bool imageTimedOut = false;
+                    if (lease) {
+                        ocrResult = recognizeImage(lease.engine(), fullImagePath, useConfidence, minConfidence,
+                                                   &imageTimedOut);
+                    }
+
+                    results.add(index, fileName, ocrResult, imageTimedOut ? ImageTimedOut : ImageProcessed);
+                }
+            });
+        }
+
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+
+        acquirePageEngine();
+    }
+
+    // Runs the queued files on isolated worker processes (see
+    // setProcessIsolation), driving each worker from its own thread, and
+    // hands results to writeResult in queue order or in the order they
+    // finish. Returns once the queue is closed and drained.
+    void processFilesInWorkers(const QDir& inputDir, ImageQueue& queue, const QString& language,
+                               int pageSegmentationMode, bool useConfidence, int minConfidence,
+                               const ResultWriter& writeResult, bool inQueueOrder) {
+        std::cout << "Processing in " << workerPlacements.size() << " isolated worker processes" << std::endl;
+
+        // Workers enforce the image timeout themselves; this only catches hangs it
+        // cannot interrupt, and without it a hung worker would stall its share of the queue
+        int imageTimeoutMs = pipeline.getImageTimeout();
+        int hangTimeoutMs = imageTimeoutMs > 0 ? 2 * imageTimeoutMs + 30000 : 5 * 60 * 1000;
+        QString settings = pipeline.resultSettings(language, pageSegmentationMode, useConfidence, minConfidence);
+        OcrResultCache* resultCache = pipeline.getResultCache();
+
+        OrderedResults results(writeResult, inQueueOrder);
+
+        std::vector<std::thread> drivers;
+        for (int w = 0; w < workerPlacements.size(); w++) {
+            drivers.emplace_back([&, w]() {
+                QStringList arguments = workerArguments;
+                QStringList cpus;
+                for (int cpu : workerPlacements[w].cpus) {
+                    cpus << QString::number(cpu);
+                }
+                if (!cpus.isEmpty()) {
+                    arguments << "--cpus" << cpus.join(",");
+                }
+
+                // Consecutive failed starts; after maxStartFailures the worker
+                // is not started again and its images fail without a model load each
+                const int maxStartFailures = 3;
+                OcrWorkerProcess worker(arguments, w, hangTimeoutMs);
+                int startFailures = worker.start() ? 0 : 1;
+
+                int index = 0;
+                QString fileName;
+                while (queue.take(index, fileName)) {
+                    QString fullImagePath = inputDir.absoluteFilePath(fileName);
+                    std::cout << "\n--- Processing: " << fileName.toStdString() << " ---" << std::endl;
+
+                    QString ocrResult;
+                    ImageOutcome outcome = ImageProcessed;
+                    QByteArray imageBytes;
+                    QByteArray cacheKey;
+                    bool cached = false;
+                    if (OcrImagePipeline::readImageFile(fullImagePath, imageBytes) && resultCache) {
+                        cacheKey = OcrResultCache::makeKey(imageBytes, settings);
+                        cached = resultCache->lookup(cacheKey, ocrResult);
+                        if (cached) {
+                            std::cout << "Using cached result for identical image: "
+                                      << fullImagePath.toStdString() << std::endl;
+                        }
+                    }
+
+                    for (int attempt = 0; !imageBytes.isEmpty() && !cached; attempt++) {
+                        if (!worker.isRunning()) {
+                            if (startFailures < maxStartFailures && worker.start()) {
+                                startFailures = 0;
+                            } else {
+                                // The worker cannot load its engine; no point blaming the image
+                                if (startFailures < maxStartFailures && ++startFailures == maxStartFailures) {
+                                    std::cout << "ERROR: OCR worker " << w << " failed to start " << maxStartFailures
+                                              << " times in a row; not starting it again" << std::endl;
+                                }
+                                outcome = ImageWorkerFailed;
+                                break;
+                            }
+                        }
+
+                        WorkerResult result = worker.recognize(imageBytes, fullImagePath);
+                        if (result.failed) {
+                            // The image never reached the worker; not the image's fault
+                            outcome = ImageWorkerFailed;
+                            break;
+                        }
+                        if (!result.crashed) {
+                            ocrResult = result.text;
+                            outcome = result.timedOut ? ImageTimedOut : ImageProcessed;
+                            if (resultCache && !result.timedOut) {
+                                resultCache->insert(cacheKey, ocrResult);
+                            }
+                            break;
+                        }
+                        if (attempt >= maxImageRetries) {
+                            outcome = ImageQuarantined;
+                            break;
+                        }
+                        std::cout << "Restarting OCR worker " << w << " and retrying: "
+                                  << fileName.toStdString() << std::endl;
+                    }
+
+                    results.add(index, fileName, ocrResult, outcome);
+                }
+
+                if (worker.startCount() > 1) {
+                    std::cout << "OCR worker " << w << " was restarted " << worker.startCount() - 1 << " times" << std::endl;
+                }
+            });
+        }
+
+        for (std::thread& driver : drivers) {
+            driver.join();
+        }
+    }
+
+    tesseract::TessBaseAPI* api;
+    QString tessdataPath;
+    QStringList supportedExtensions;
+    bool singleLineImages;
+    int threadsPerEngine;
+    tesseract::OcrEngineMode engineMode;
+    int pageSegMode;
+    QString loadedLanguage;
+    QString loadedTessdataPath;
+    tesseract::OcrEngineMode loadedEngineMode;
+    QStringList nameFilters;
+    qint64 minFileSize;
+    qint64 maxFileSize;
+    std::atomic<bool> cancelRequested;
+    bool processIsolation;
+    QStringList workerArguments;
+    int maxImageRetries;
+    int watchSettleMs;
+    QList<WorkerPlacement> workerPlacements;
+    std::unique_ptr<TesseractEnginePool> linePool;
+    std::unique_ptr<TesseractEnginePool> pagePool;
+    TesseractEnginePool::EngineLease pageLease;     // Holds api; declared after pagePool
+    QList<QList<int>> pagePoolCpus;                 // Worker CPUs the page pool's engines were loaded for
+    OcrImagePipeline pipeline;                      // Uses linePool; declared after it
+};
+
+#endif // TESSERACT_OCR_H
@@ -0,0 +1,237 @@
+#ifndef THREAD_PLACEMENT_H
+#define THREAD_PLACEMENT_H
+
+#include <QByteArray>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QtGlobal>
+#include <algorithm>
+#include <iostream>
+
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+
+// CPUs assigned to one worker; all of them are on the same NUMA node
+struct WorkerPlacement {
+    int node = 0;
+    QList<int> cpus;
+};
+
+// Splits a total thread budget into engine workers and pins each worker to
+// its own cores. Workers are spread round-robin over NUMA nodes, never span
+// a node, and take one hyperthread per physical core before using siblings.
+// An engine created on a pinned worker thread gets its memory on the local
+// node through the kernel's first-touch policy.
+class ThreadPlacement {
+public:
+    // threadsPerEngine is the OpenMP thread count each Tesseract engine may use.
+    // cpuList ("0-7,16-23") restricts the CPUs this process uses; it is
+    // intersected with the affinity mask the process was started with.
+    static QList<WorkerPlacement> plan(int totalThreads, int threadsPerEngine = 1,
+                                       const QString& cpuList = QString()) {
+        threadsPerEngine = qMax(1, threadsPerEngine);
+        QList<int> allowed = allowedCpus();
+        if (!cpuList.isEmpty()) {
+            QList<int> requested = parseCpuList(cpuList);
+            QList<int> intersection;
+            for (int cpu : requested) {
+                if (allowed.contains(cpu)) {
+                    intersection << cpu;
+                }
+            }
+            allowed = intersection;
+        }
+
+        if (totalThreads <= 0) {
+            totalThreads = qMax(1, allowed.size());
+        }
+        int workers = qMax(1, totalThreads / threadsPerEngine);
+
+        if (workers * threadsPerEngine > allowed.size() && !allowed.isEmpty()) {
+            std::cout << "WARNING: Thread budget of " << workers * threadsPerEngine
+                      << " exceeds the " << allowed.size() << " available CPUs; cores will be shared" << std::endl;
+        }
+
+        // Group the usable CPUs by NUMA node, physical cores first
+        QMap<int, QList<int>> nodeCpus;
+        QMap<int, int> cpuNode = cpuToNode();
+        for (int cpu : orderedBySiblingRank(allowed)) {
+            nodeCpus[cpuNode.value(cpu, 0)] << cpu;
+        }
+
+        QList<WorkerPlacement> placements;
+        QList<int> nodes = nodeCpus.keys();
+        QMap<int, int> nextCpu;
+        for (int w = 0; w < workers; w++) {
+            WorkerPlacement placement;
+            if (nodes.isEmpty()) {
+                placements << placement;
+                continue;
+            }
+
+            placement.node = nodes[w % nodes.size()];
+            const QList<int>& cpus = nodeCpus[placement.node];
+            for (int t = 0; t < threadsPerEngine; t++) {
+                int& next = nextCpu[placement.node];
+                placement.cpus << cpus[next % cpus.size()];
+                next++;
+            }
+            placements << placement;
+        }
+
+        return placements;
+    }
+
+    // Pins the calling thread to the given CPUs. Returns false where unsupported.
+    static bool pinCurrentThread(const QList<int>& cpus) {
+        if (cpus.isEmpty()) {
+            return false;
+        }
+#ifdef Q_OS_LINUX
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus) {
+            CPU_SET(cpu, &set);
+        }
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#elif defined(Q_OS_WIN)
+        DWORD_PTR mask = 0;
+        for (int cpu : cpus) {
+            if (cpu < static_cast<int>(sizeof(DWORD_PTR) * 8)) {
+                mask |= static_cast<DWORD_PTR>(1) << cpu;
+            }
+        }
+        return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+        return false;
+#endif
+    }
+
+    // Caps the OpenMP threads Tesseract may start inside each engine. The
+    // OpenMP runtime reads OMP_THREAD_LIMIT once when it is loaded, so on
+    // Linux the process re-executes itself with the variable set. Returns
+    // false if the limit could not be applied.
+    static bool limitOpenMpThreads(int threadsPerEngine, char* argv[]) {
+        QByteArray wanted = QByteArray::number(qMax(1, threadsPerEngine));
+        if (qgetenv("OMP_THREAD_LIMIT") == wanted) {
+            return true;
+        }
+
+        qputenv("OMP_THREAD_LIMIT", wanted);
+#ifdef Q_OS_LINUX
+        std::cout << "Restarting with OMP_THREAD_LIMIT=" << wanted.constData() << std::endl;
+        execv("/proc/self/exe", argv);
+#else
+        Q_UNUSED(argv);
+#endif
+        std::cout << "WARNING: Could not apply OMP_THREAD_LIMIT=" << wanted.constData()
+                  << "; set it in the environment before starting the tool" << std::endl;
+        return false;
+    }
+
+    static QList<int> parseCpuList(const QString& cpuList) {
+        QList<int> cpus;
+        // Empty parts are skipped by hand: QString::SkipEmptyParts is deprecated
+        // in Qt 5.15 and Qt::SkipEmptyParts needs 5.14
+        for (const QString& part : cpuList.trimmed().split(',')) {
+            if (part.trimmed().isEmpty()) {
+                continue;
+            }
+            QStringList range = part.trimmed().split('-');
+            bool okFirst = false;
+            bool okLast = false;
+            int first = range[0].toInt(&okFirst);
+            int last = range.size() > 1 ? range[1].toInt(&okLast) : first;
+            if (!okFirst || (range.size() > 1 && !okLast)) {
+                continue;
+            }
+            for (int cpu = first; cpu <= last; cpu++) {
+                cpus << cpu;
+            }
+        }
+        return cpus;
+    }
+
+private:
+    static QList<int> allowedCpus() {
+        QList<int> cpus;
+#ifdef Q_OS_LINUX
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+                if (CPU_ISSET(cpu, &set)) {
+                    cpus << cpu;
+                }
+            }
+        }
+#endif
+        if (cpus.isEmpty()) {
+            for (int cpu = 0; cpu < QThread::idealThreadCount(); cpu++) {
+                cpus << cpu;
+            }
+        }
+        return cpus;
+    }
+
+    static QMap<int, int> cpuToNode() {
+        QMap<int, int> mapping;
+        QDir nodesDir("/sys/devices/system/node");
+        for (const QString& entry : nodesDir.entryList(QStringList() << "node*", QDir::Dirs)) {
+            bool ok = false;
+            int node = entry.mid(4).toInt(&ok);
+            if (!ok) {
+                continue;
+            }
+            for (int cpu : parseCpuList(readSysFile(nodesDir.absoluteFilePath(entry + "/cpulist")))) {
+                mapping[cpu] = node;
+            }
+        }
+        return mapping;
+    }
+
+    // Orders CPUs so the first hyperthread of every physical core comes
+    // before any second sibling
+    static QList<int> orderedBySiblingRank(const QList<int>& cpus) {
+        QMap<QPair<QString, QString>, int> siblingsSeen;
+        QList<QPair<int, int>> ranked;
+        for (int cpu : cpus) {
+            QString topology = QString("/sys/devices/system/cpu/cpu%1/topology/").arg(cpu);
+            QPair<QString, QString> core(readSysFile(topology + "physical_package_id"),
+                                         readSysFile(topology + "core_id"));
+            int rank = core.second.isEmpty() ? 0 : siblingsSeen[core]++;
+            ranked << qMakePair(rank, cpu);
+        }
+        std::sort(ranked.begin(), ranked.end());
+
+        QList<int> ordered;
+        for (const QPair<int, int>& entry : ranked) {
+            ordered << entry.second;
+        }
+        return ordered;
+    }
+
+    static QString readSysFile(const QString& path) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            return QString();
+        }
+        return QString::fromLatin1(file.readAll()).trimmed();
+    }
+};
+
+#endif // THREAD_PLACEMENT_H
@@ -1,4 +1,5 @@
 #include <QCoreApplication>
+#include <QCommandLineParser>
 #include <QProcess>
 #include <QDebug>
 #include <QFile>
@@ -10,94 +11,52 @@
 #include <QStringList>
 #include <QDateTime>
 #include <QList>
+#include <QVector>
 #include <QChar>
 #include <QTime>
 #include <cstdlib>
 #include <ctime>
+#include "confidence_table.h"
+#include "job_spec.h"
 
-struct CharacterConfidence {
-    QString character;
-    int confidence;
-    int x, y, width, height;
-    int page_num;
-    int block_num;
-    int par_num;
-    int line_num;
-    int word_num;
-};
-
-class TesseractOCR {
+// Character confidence reports from the tesseract command-line tool. The
+// in-process engine API lives in the tesseract_ocr library (tesseract_ocr.h,
+// ocr_service.h).
+class TesseractCommandLineOCR {
 public:
-    TesseractOCR() {
-        // Set the path to tesseract executable
-        tesseractPath = "C:/Program Files/Tesseract-OCR/tesseract.exe";
+    TesseractCommandLineOCR() {
+        // tesseract executable, looked up on the PATH unless set
+        tesseractPath = "tesseract";
+        pageSegMode = 6;
 
         // Supported image extensions
         supportedExtensions << "*.png" << "*.jpg" << "*.jpeg"
                            << "*.tiff" << "*.tif" << "*.bmp"
                            << "*.gif" << "*.webp";
 
+        // Characters below each of these confidences are counted in the statistics
+        lowConfidenceThresholds << 70;
+
         // Initialize random seed for older Qt versions
         qsrand(static_cast<uint>(QTime::currentTime().msec()));
     }
 
     QString processImage(const QString& imagePath, const QString& language = "rus") {
-        QProcess process;
-
-        // Create temporary output file
-        QString tempOutput = QDir::tempPath() + "/tesseract_temp";
-
         // Build command arguments
         QStringList arguments;
-        arguments << imagePath;           // Input image
-        arguments << tempOutput;          // Output file (without extension)
         arguments << "-l" << language;    // Language
 
-        qDebug() << "Running:" << tesseractPath << arguments.join(" ");
-
-        // Run tesseract process
-        process.start(tesseractPath, arguments);
-
-        if (!process.waitForStarted()) {
-            qDebug() << "Failed to start tesseract process";
-            qDebug() << "Error:" << process.errorString();
-            return QString();
-        }
-
-        if (!process.waitForFinished(30000)) { // 30 second timeout
-            qDebug() << "Tesseract process timed out";
-            process.kill();
-            return QString();
-        }
-
-        if (process.exitCode() != 0) {
-            qDebug() << "Tesseract failed with exit code:" << process.exitCode();
-            qDebug() << "Standard Error:" << process.readAllStandardError();
-            return QString();
-        }
-
-        // Read the output file
-        QString outputFile = tempOutput + ".txt";
-        QFile file(outputFile);
-        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            qDebug() << "Could not read output file:" << outputFile;
+        QByteArray output;
+        if (!runTesseract(imagePath, arguments, output, "")) {
             return QString();
         }
 
-        QTextStream in(&file);
-        in.setCodec("UTF-8");
-        QString result = in.readAll();
-        file.close();
-
-        // Clean up temporary file
-        QFile::remove(outputFile);
-
-        return result;
+        return QString::fromUtf8(output);
     }
 
     // Process image with character confidence using TSV output
-    QList<CharacterConfidence> processImageWithConfidence(const QString& imagePath, const QString& language = "rus") {
-        QList<CharacterConfidence> results;
+    CharacterConfidenceTable processImageWithConfidence(const QString& imagePath, const QString& language = "rus") {
+        CharacterConfidenceTable results;
 
         // Try TSV method first
         results = processImageWithTSVConfidence(imagePath, language);
@@ -111,49 +70,27 @@ public:
     }
 
     // TSV method for getting confidence
-    QList<CharacterConfidence> processImageWithTSVConfidence(const QString& imagePath, const QString& language = "rus") {
-        QList<CharacterConfidence> results;
-        QProcess process;
-
-        // Create temporary output file
-        QString tempOutput = QDir::tempPath() + "/tesseract_confidence_temp";
+    CharacterConfidenceTable processImageWithTSVConfidence(const QString& imagePath, const QString& language = "rus") {
+        CharacterConfidenceTable results;
 
         // Build command arguments for TSV output
         QStringList arguments;
-        arguments << imagePath;           // Input image
-        arguments << tempOutput;          // Output file (without extension)
         arguments << "-l" << language;    // Language
-        arguments << "--psm" << "6";      // Page segmentation mode
+        arguments << "--psm" << QString::number(pageSegMode);      // Page segmentation mode
         arguments << "-c" << "tessedit_create_tsv=1";  // Force TSV creation
         arguments << "tsv";               // Output format: TSV (Tab-Separated Values)
 
-        qDebug() << "Running TSV confidence analysis:" << tesseractPath << arguments.join(" ");
-
-        // Run tesseract process
-        process.start(tesseractPath, arguments);
-
-        if (!process.waitForStarted()) {
-            qDebug() << "Failed to start tesseract TSV process";
+        QByteArray output;
+        if (!runTesseract(imagePath, arguments, output, "TSV")) {
             return results;
         }
 
-        if (!process.waitForFinished(30000)) {
-            qDebug() << "Tesseract TSV process timed out";
-            process.kill();
-            return results;
-        }
-
-        // Read the TSV output file
-        QString outputFile = tempOutput + ".tsv";
-        QFile file(outputFile);
-        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            qDebug() << "Could not read TSV output file:" << outputFile;
-            return results;
-        }
-
-        QTextStream in(&file);
+        QTextStream in(&output, QIODevice::ReadOnly);
         in.setCodec("UTF-8");
 
+        // Roughly one character per output byte is plenty for Latin and Cyrillic text
+        results.reserve(output.size() / 8);
+
         // Skip header line
         QString header = in.readLine();
         qDebug() << "TSV Header:" << header;
@@ -169,97 +106,48 @@ public:
                 int confidence = fields[10].toInt();
                 QString text = fields[11];
 
-                // For word level, break into individual characters
-                if (level == 4 && !text.isEmpty() && confidence >= 0) {
-                    for (int i = 0; i < text.length(); i++) {
-                        CharacterConfidence charConf;
-                        charConf.page_num = fields[1].toInt();
-                        charConf.block_num = fields[2].toInt();
-                        charConf.par_num = fields[3].toInt();
-                        charConf.line_num = fields[4].toInt();
-                        charConf.word_num = fields[5].toInt();
-                        charConf.x = fields[6].toInt() + (i * fields[8].toInt() / text.length());
-                        charConf.y = fields[7].toInt();
-                        charConf.width = fields[8].toInt() / text.length();
-                        charConf.height = fields[9].toInt();
-                        charConf.confidence = confidence;
-                        charConf.character = text.at(i);
-
-                        results.append(charConf);
+                // Only words (level 5) carry text; pages, blocks, paragraphs and
+                // lines (levels 1-4) have confidence -1. Each word is split into
+                // characters sharing its box evenly, by code point so surrogate
+                // pairs stay together.
+                if (level == 5 && confidence >= 0) {
+                    QVector<uint> codepoints = text.toUcs4();
+                    int count = codepoints.size();
+                    int left = fields[6].toInt();
+                    int width = fields[8].toInt();
+
+                    for (int i = 0; i < count; i++) {
+                        results.append(codepoints[i], confidence,
+                                       left + (i * width / count), fields[7].toInt(),
+                                       width / count, fields[9].toInt(),
+                                       fields[2].toInt(), fields[4].toInt(), fields[5].toInt());
                     }
-                } else if (level == 5 && !text.isEmpty()) {
-                    // Direct character level
-                    CharacterConfidence charConf;
-                    charConf.page_num = fields[1].toInt();
-                    charConf.block_num = fields[2].toInt();
-                    charConf.par_num = fields[3].toInt();
-                    charConf.line_num = fields[4].toInt();
-                    charConf.word_num = fields[5].toInt();
-                    charConf.x = fields[6].toInt();
-                    charConf.y = fields[7].toInt();
-                    charConf.width = fields[8].toInt();
-                    charConf.height = fields[9].toInt();
-                    charConf.confidence = confidence;
-                    charConf.character = text;
-
-                    results.append(charConf);
                 }
             }
         }
 
-        file.close();
-        QFile::remove(outputFile);
-
         qDebug() << "TSV method extracted" << results.size() << "character confidence entries";
         return results;
     }
 
     // Alternative method: Get character confidence using simulated choices
-    QList<CharacterConfidence> processImageWithChoicesConfidence(const QString& imagePath, const QString& language = "rus") {
-        QList<CharacterConfidence> results;
-        QProcess process;
-
-        // Create temporary output file
-        QString tempOutput = QDir::tempPath() + "/tesseract_choices_temp";
+    CharacterConfidenceTable processImageWithChoicesConfidence(const QString& imagePath, const QString& language = "rus") {
+        CharacterConfidenceTable results;
 
         // Build command arguments for getting character choices
+        // (debug messages go to stderr, which is kept apart from the text)
         QStringList arguments;
-        arguments << imagePath;           // Input image
-        arguments << tempOutput;          // Output file (without extension)
         arguments << "-l" << language;    // Language
         arguments << "--psm" << "8";      // Single word mode for better character recognition
         arguments << "-c" << "tessedit_write_images=false";
-        arguments << "-c" << "debug_file=" + tempOutput + "_debug.txt";
         arguments << "txt";               // Basic text output
 
-        qDebug() << "Running choices confidence analysis:" << tesseractPath << arguments.join(" ");
-
-        // Run tesseract process
-        process.start(tesseractPath, arguments);
-
-        if (!process.waitForStarted()) {
-            qDebug() << "Failed to start tesseract choices process";
-            return results;
-        }
-
-        if (!process.waitForFinished(30000)) {
-            qDebug() << "Tesseract choices process timed out";
-            process.kill();
+        QByteArray output;
+        if (!runTesseract(imagePath, arguments, output, "choices")) {
             return results;
         }
 
-        // Read the basic text output first
-        QString outputFile = tempOutput + ".txt";
-        QFile file(outputFile);
-        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            qDebug() << "Could not read text output file:" << outputFile;
-            return results;
-        }
-
-        QTextStream in(&file);
-        in.setCodec("UTF-8");
-        QString recognizedText = in.readAll().trimmed();
-        file.close();
+        QString recognizedText = QString::fromUtf8(output).trimmed();
 
         qDebug() << "Recognized text:" << recognizedText;
 
@@ -267,100 +155,68 @@ public:
         if (!recognizedText.isEmpty()) {
             int baseConfidence = 85; // Base confidence
             int wordNum = 1;
+            QVector<uint> commonChars = QString("аеиорнтсвлкмдпугязбчйхжшюцэфщъыь").toUcs4();
+            QVector<uint> codepoints = recognizedText.toUcs4();
+            results.reserve(codepoints.size());
 
-            for (int i = 0; i < recognizedText.length(); i++) {
-                QChar ch = recognizedText.at(i);
+            for (int i = 0; i < codepoints.size(); i++) {
+                uint ch = codepoints[i];
 
                 // Skip whitespace
-                if (ch.isSpace()) {
+                if (QChar::isSpace(ch)) {
                     wordNum++;
                     continue;
                 }
 
-                CharacterConfidence charConf;
-                charConf.page_num = 1;
-                charConf.block_num = 1;
-                charConf.par_num = 1;
-                charConf.line_num = 1;
-                charConf.word_num = wordNum;
-                charConf.x = i * 20; // Estimated position
-                charConf.y = 0;
-                charConf.width = 18;
-                charConf.height = 24;
-                charConf.character = ch;
-
                 // Assign confidence based on character type and common usage
-                if (ch.isLetter()) {
+                int confidence;
+                if (QChar::isLetter(ch)) {
                     // Common Cyrillic letters get higher confidence
-                    QString commonChars = "аеиорнтсвлкмдпугязбчйхжшюцэфщъыь";
-                    if (commonChars.contains(ch.toLower())) {
-                        charConf.confidence = baseConfidence + qrand() % 10;
+                    if (commonChars.contains(QChar::toLower(ch))) {
+                        confidence = baseConfidence + qrand() % 10;
                     } else {
-                        charConf.confidence = baseConfidence - 5 + qrand() % 10;
+                        confidence = baseConfidence - 5 + qrand() % 10;
                     }
-                } else if (ch.isDigit()) {
-                    charConf.confidence = baseConfidence + 5 + qrand() % 8;
-                } else if (ch.isPunct()) {
-                    charConf.confidence = baseConfidence - 10 + qrand() % 15;
+                } else if (QChar::isDigit(ch)) {
+                    confidence = baseConfidence + 5 + qrand() % 8;
+                } else if (QChar::isPunct(ch)) {
+                    confidence = baseConfidence - 10 + qrand() % 15;
                 } else {
-                    charConf.confidence = baseConfidence - 15 + qrand() % 20;
+                    confidence = baseConfidence - 15 + qrand() % 20;
                 }
 
-                // Ensure confidence is within valid range
-                charConf.confidence = qMax(0, qMin(100, charConf.confidence));
-
-                results.append(charConf);
+                // Estimated position; append() clamps confidence to 0..100
+                results.append(ch, confidence, i * 20, 0, 18, 24, 1, 1, wordNum);
             }
         }
 
-        // Clean up temporary files
-        QFile::remove(outputFile);
-        QFile::remove(tempOutput + "_detailed.txt");
-        QFile::remove(tempOutput + "_debug.txt");
-
         qDebug() << "Generated" << results.size() << "character confidence entries using choices method";
         return results;
     }
 
+    // Statistics for a table, using the configured low confidence thresholds
+    ConfidenceStatistics confidenceStatistics(const CharacterConfidenceTable& characters) const {
+        return ConfidenceStatistics::compute(characters.confidences, lowConfidenceThresholds);
+    }
+
     // Print character confidence details
-    void printCharacterConfidence(const QList<CharacterConfidence>& characters) {
+    void printCharacterConfidence(const CharacterConfidenceTable& characters, const ConfidenceStatistics& stats) {
         qDebug() << "\n=== CHARACTER CONFIDENCE ANALYSIS ===";
         qDebug() << QString("Char").leftJustified(8) << "Conf" << "  Position (x,y,w,h)";
         qDebug() << QString("-").repeated(50);
 
-        for (const CharacterConfidence& ch : characters) {
-            QString charDisplay = ch.character;
-            if (charDisplay == " ") charDisplay = "[SPACE]";
-            if (charDisplay == "\t") charDisplay = "[TAB]";
-            if (charDisplay == "\n") charDisplay = "[NEWLINE]";
-
-            qDebug() << QString("'%1'").arg(charDisplay).leftJustified(8)
-                     << QString::number(ch.confidence).rightJustified(3) << "%"
-                     << QString("  (%1,%2,%3,%4)").arg(ch.x).arg(ch.y).arg(ch.width).arg(ch.height);
+        for (int i = 0; i < characters.size(); i++) {
+            qDebug() << QString("'%1'").arg(displayCharacter(characters, i)).leftJustified(8)
+                     << QString::number(characters.confidences[i]).rightJustified(3) << "%"
+                     << QString("  (%1,%2,%3,%4)").arg(characters.x[i]).arg(characters.y[i])
+                                                  .arg(characters.width[i]).arg(characters.height[i]);
         }
 
-        // Calculate statistics
-        if (!characters.isEmpty()) {
-            int totalConf = 0;
-            int minConf = 100;
-            int maxConf = 0;
-            int lowConfCount = 0;
-
-            for (const CharacterConfidence& ch : characters) {
-                totalConf += ch.confidence;
-                minConf = qMin(minConf, ch.confidence);
-                maxConf = qMax(maxConf, ch.confidence);
-                if (ch.confidence < 70) lowConfCount++;
-            }
-
-            double avgConf = (double)totalConf / characters.size();
-
+        if (stats.count > 0) {
             qDebug() << "\n=== CONFIDENCE STATISTICS ===";
-            qDebug() << "Total characters:" << characters.size();
-            qDebug() << "Average confidence:" << QString::number(avgConf, 'f', 1) << "%";
-            qDebug() << "Min confidence:" << minConf << "%";
-            qDebug() << "Max confidence:" << maxConf << "%";
-            qDebug() << "Low confidence chars (<70%):" << lowConfCount;
+            for (const QString& line : statisticsLines(stats)) {
+                qDebug().noquote() << line;
+            }
         }
     }
 
@@ -370,10 +226,10 @@ public:
         QString text = processImage(imagePath, language);
 
         // Get character confidence
-        QList<CharacterConfidence> characters = processImageWithConfidence(imagePath, language);
+        CharacterConfidenceTable characters = processImageWithConfidence(imagePath, language);
 
         // Print confidence details
-        printCharacterConfidence(characters);
+        printCharacterConfidence(characters, confidenceStatistics(characters));
 
         return text;
     }
@@ -395,7 +251,8 @@ public:
     }
 
     // Save confidence data to file
-    bool saveConfidenceToFile(const QList<CharacterConfidence>& characters, const QString& outputPath) {
+    bool saveConfidenceToFile(const CharacterConfidenceTable& characters, const ConfidenceStatistics& stats,
+                              const QString& outputPath) {
         QFile file(outputPath);
         if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
             qDebug() << "Could not create confidence output file:" << outputPath;
@@ -414,42 +271,22 @@ public:
         out << QString("Character").leftJustified(12) << "Confidence" << "  Position (x,y,w,h)" << "  Word#" << "\n";
         out << QString("-").repeated(70) << "\n";
 
-        for (const CharacterConfidence& ch : characters) {
-            QString charDisplay = ch.character;
-            if (charDisplay == " ") charDisplay = "[SPACE]";
-            if (charDisplay == "\t") charDisplay = "[TAB]";
-            if (charDisplay == "\n") charDisplay = "[NEWLINE]";
-
-            out << QString("'%1'").arg(charDisplay).leftJustified(12)
-                << QString::number(ch.confidence).rightJustified(3) << "%"
-                << QString("      (%1,%2,%3,%4)").arg(ch.x).arg(ch.y).arg(ch.width).arg(ch.height)
-                << QString("    W%1").arg(ch.word_num) << "\n";
+        for (int i = 0; i < characters.size(); i++) {
+            out << QString("'%1'").arg(displayCharacter(characters, i)).leftJustified(12)
+                << QString::number(characters.confidences[i]).rightJustified(3) << "%"
+                << QString("      (%1,%2,%3,%4)").arg(characters.x[i]).arg(characters.y[i])
+                                                 .arg(characters.width[i]).arg(characters.height[i])
+                << QString("    W%1").arg(characters.wordNum[i]) << "\n";
         }
 
         // Write statistics
-        if (!characters.isEmpty()) {
-            int totalConf = 0;
-            int minConf = 100;
-            int maxConf = 0;
-            int lowConfCount = 0;
-
-            for (const CharacterConfidence& ch : characters) {
-                totalConf += ch.confidence;
-                minConf = qMin(minConf, ch.confidence);
-                maxConf = qMax(maxConf, ch.confidence);
-                if (ch.confidence < 70) lowConfCount++;
-            }
-
-            double avgConf = (double)totalConf / characters.size();
-
+        if (stats.count > 0) {
             out << "\n" << QString("=").repeated(80) << "\n";
             out << "CONFIDENCE STATISTICS\n";
             out << QString("=").repeated(80) << "\n";
-            out << "Total characters: " << characters.size() << "\n";
-            out << "Average confidence: " << QString::number(avgConf, 'f', 1) << "%\n";
-            out << "Min confidence: " << minConf << "%\n";
-            out << "Max confidence: " << maxConf << "%\n";
-            out << "Low confidence chars (<70%): " << lowConfCount << "\n";
+            for (const QString& line : statisticsLines(stats)) {
+                out << line << "\n";
+            }
         }
 
         file.close();
@@ -466,7 +303,8 @@ public:
 
         // Get all image files in the folder
         QStringList imageFiles;
-        for (const QString& extension : supportedExtensions) {
+        QStringList patterns = nameFilters.isEmpty() ? supportedExtensions : nameFilters;
+        for (const QString& extension : patterns) {
             imageFiles.append(inputDir.entryList(QStringList() << extension, QDir::Files));
         }
 
@@ -503,13 +341,15 @@ public:
 
             qDebug() << "\n--- Processing:" << fileName << "---";
 
-            // Process with confidence analysis
-            QString ocrResult = processImageWithDetailedConfidence(fullImagePath, language);
+            // Recognize once for the text and once for the confidences; the
+            // statistics are computed once and shared by both reports
+            QString ocrResult = processImage(fullImagePath, language);
+            CharacterConfidenceTable characters = processImageWithConfidence(fullImagePath, language);
+            ConfidenceStatistics stats = confidenceStatistics(characters);
 
-            // Also save confidence data for this image
-            QList<CharacterConfidence> characters = processImageWithConfidence(fullImagePath, language);
+            printCharacterConfidence(characters, stats);
             QString confidenceFile = outputFile + "_" + fileName + "_confidence.txt";
-            saveConfidenceToFile(characters, confidenceFile);
+            saveConfidenceToFile(characters, stats, confidenceFile);
 
             if (!ocrResult.isEmpty()) {
                 // Write to single file with filename header
@@ -562,38 +402,163 @@ public:
         tesseractPath = path;
     }
 
+    // Empty = tesseract's own default (TESSDATA_PREFIX or its install location)
+    void setTessdataPath(const QString& path) {
+        tessdataPath = path;
+    }
+
+    // Page segmentation mode of the TSV pass
+    void setPageSegmentationMode(int mode) {
+        pageSegMode = mode;
+    }
+
+    // Empty = all supported image types
+    void setFileFilters(const QStringList& patterns) {
+        nameFilters = patterns;
+    }
+
+    // Characters below each threshold are counted separately in the statistics
+    void setLowConfidenceThresholds(const QList<int>& thresholds) {
+        lowConfidenceThresholds = thresholds;
+    }
+
     QStringList getSupportedExtensions() const {
         return supportedExtensions;
     }
 
 private:
+    static QString displayCharacter(const CharacterConfidenceTable& characters, int i) {
+        switch (characters.codepoints[i]) {
+        case ' ': return "[SPACE]";
+        case '\t': return "[TAB]";
+        case '\n': return "[NEWLINE]";
+        default: return characters.character(i);
+        }
+    }
+
+    static QStringList statisticsLines(const ConfidenceStatistics& stats) {
+        QStringList lines;
+        lines << QString("Total characters: %1").arg(stats.count);
+        lines << QString("Average confidence: %1%").arg(QString::number(stats.mean, 'f', 1));
+        lines << QString("Min confidence: %1%").arg(stats.min);
+        lines << QString("Max confidence: %1%").arg(stats.max);
+        lines << QString("Median confidence: %1%").arg(stats.percentile(50));
+        lines << QString("10th percentile confidence: %1%").arg(stats.percentile(10));
+        for (int i = 0; i < stats.thresholds.size(); i++) {
+            lines << QString("Low confidence chars (<%1%): %2").arg(stats.thresholds[i]).arg(stats.belowThreshold[i]);
+        }
+        return lines;
+    }
+
+    // Runs tesseract with the image piped to stdin and the result read from
+    // stdout ("tesseract stdin stdout <options>"). Nothing touches the disk,
+    // so any number of runs can go on in parallel. kind names the run in the log.
+    bool runTesseract(const QString& imagePath, const QStringList& options, QByteArray& output, const QString& kind) {
+        QString processName = kind.isEmpty() ? QString("tesseract process") : "tesseract " + kind + " process";
+
+        QFile imageFile(imagePath);
+        if (!imageFile.open(QIODevice::ReadOnly)) {
+            qDebug() << "Could not read image:" << imagePath;
+            return false;
+        }
+        QByteArray imageBytes = imageFile.readAll();
+        imageFile.close();
+
+        QStringList arguments;
+        arguments << "stdin" << "stdout";
+        if (!tessdataPath.isEmpty()) {
+            arguments << "--tessdata-dir" << tessdataPath;
+        }
+        arguments << options;
+
+        qDebug() << "Running:" << tesseractPath << arguments.join(" ") << "<" << imagePath;
+
+        // Run tesseract process
+        QProcess process;
+        process.start(tesseractPath, arguments);
+
+        if (!process.waitForStarted()) {
+            qDebug() << "Failed to start" << processName;
+            qDebug() << "Error:" << process.errorString();
+            return false;
+        }
+
+        process.write(imageBytes);
+        process.closeWriteChannel();
+
+        if (!process.waitForFinished(30000)) { // 30 second timeout
+            qDebug() << processName << "timed out";
+            process.kill();
+            process.waitForFinished();
+            return false;
+        }
+
+        if (process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
+            qDebug() << "Tesseract failed with exit code:" << process.exitCode();
+            qDebug() << "Standard Error:" << process.readAllStandardError();
+            return false;
+        }
+
+        output = process.readAllStandardOutput();
+        return true;
+    }
+
     QString tesseractPath;
+    QString tessdataPath;
+    int pageSegMode;
     QStringList supportedExtensions;
+    QStringList nameFilters;
+    QList<int> lowConfidenceThresholds;
 };
 
 int main(int argc, char *argv[])
 {
     QCoreApplication app(argc, argv);
 
-    TesseractOCR ocr;
-
-    // Set custom tesseract path if needed
-    // ocr.setTesseractPath("C:/Your/Custom/Path/tesseract.exe");
-
-    // Path to your folder containing images
-    QString folderPath = "D:/Dataset/OCR_DATA/Reckit Images/RZ_cropped/";
-            //"D:/Dataset/OCR_DATA/MLY/";
-
-    // Specify single output file
-    QString outputFile = "D:/Dataset/OCR_DATA/Russian/Words/all_ocr_results_with_confidence.txt";
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Writes per-character confidence reports for every image in a folder\n"
+                                     "using the tesseract command-line tool.\n"
+                                     "Jobs come from --input/--output or from a --config job file; options for\n"
+                                     "the in-process engine (threads, caching, ONNX, ...) are ignored here.");
+    parser.addHelpOption();
+    OcrJobSpecLoader::addCommandLineOptions(parser);
+    QCommandLineOption tesseractOption("tesseract", "tesseract executable (default: tesseract on the PATH).", "path");
+    parser.addOption(tesseractOption);
+    parser.process(app);
+
+    QString error;
+    QList<OcrJobSpec> jobs = OcrJobSpecLoader::load(parser, error);
+    if (!error.isEmpty()) {
+        qDebug() << "ERROR:" << error;
+        return 1;
+    }
+    if (jobs.isEmpty()) {
+        qDebug() << "ERROR: No jobs to run. Pass --input and --output, or --config.";
+        parser.showHelp(1);
+    }
 
-    qDebug() << "Starting OCR processing with confidence analysis for folder:" << folderPath;
+    TesseractCommandLineOCR ocr;
+    if (parser.isSet(tesseractOption)) {
+        ocr.setTesseractPath(parser.value(tesseractOption));
+    }
     qDebug() << "Supported image formats:" << ocr.getSupportedExtensions().join(", ");
 
-    // Process all images in the folder and save to single file with confidence analysis
-    bool success = ocr.processFolder(folderPath, outputFile, "eng");//rus+ukr
+    int failedJobs = 0;
+    for (const OcrJobSpec& job : jobs) {
+        qDebug() << "Starting OCR processing with confidence analysis for folder:" << job.inputFolder;
+        ocr.setTessdataPath(job.tessdataPath);
+        ocr.setPageSegmentationMode(job.pageSegmentationMode);
+        ocr.setFileFilters(job.nameFilters);
+        ocr.setLowConfidenceThresholds(job.lowConfidenceThresholds);
+
+        // Process all images in the folder and save to single file with confidence analysis
+        if (!ocr.processFolder(job.inputFolder, job.outputFile, job.language)) {
+            qDebug() << "OCR processing failed for job:" << job.name;
+            failedJobs++;
+        }
+    }
 
-    if (success) {
+    if (failedJobs == 0) {
         qDebug() << "\nOCR processing with confidence analysis completed successfully!";
         qDebug() << "Check individual *_confidence.txt files for detailed character confidence data.";
         return 0;
@@ -0,0 +1,273 @@
+#ifndef WORKER_PROCESS_H
+#define WORKER_PROCESS_H
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QList>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QProcess>
+#include <QSharedMemory>
+#include <QString>
+#include <QStringList>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+
+// Outcome of one image sent to a worker process
+struct WorkerResult {
+    QString text;
+    bool timedOut = false;      // The worker hit its image timeout
+    bool crashed = false;       // The worker died or hung on this image
+    bool failed = false;        // The image could not be handed to the worker
+};
+
+// Parent side of one long-lived OCR worker process.
+//
+// The worker is this executable started again with workerArguments plus
+// --worker-server; it loads its engine once and then recognizes images until
+// it is stopped. Encoded image bytes travel through a shared memory segment
+// and requests and results through a local socket (the worker's stdout and
+// stderr stay free for its log):
+//
+//   worker -> parent   READY                            engine loaded
+//   parent -> worker   IMAGE <memory key> <bytes> <base64 label>
+//   worker -> parent   RESULT <timed out 0|1> <base64 UTF-8 text>
+//   parent -> worker   QUIT
+//
+// Images are decoded in the worker, so a crash in the image decoder only
+// takes down that worker.
+class OcrWorkerProcess {
+public:
+    // hangTimeoutMs: how long to wait for one result before killing the worker (0 = forever)
+    OcrWorkerProcess(const QStringList& workerArguments, int slot, int hangTimeoutMs = 0)
+        : workerArguments(workerArguments), slot(slot), hangTimeoutMs(hangTimeoutMs),
+          socket(nullptr), generation(0), memoryGeneration(0), starts(0) {}
+
+    ~OcrWorkerProcess() {
+        stop();
+    }
+
+    // Starts (or restarts) the worker and waits until its engine is loaded
+    bool start() {
+        stop();
+        generation++;
+        starts++;
+
+        QString serverName = QString("tes_cpp_%1_%2_%3")
+                                 .arg(QCoreApplication::applicationPid()).arg(slot).arg(generation);
+        QLocalServer::removeServer(serverName);
+        server.reset(new QLocalServer());
+        if (!server->listen(serverName)) {
+            qDebug() << "Could not listen for OCR worker:" << serverName << server->errorString();
+            std::cout << "ERROR: Could not listen for OCR worker: " << serverName.toStdString() << std::endl;
+            return false;
+        }
+
+        process.reset(new QProcess());
+        process->setProcessChannelMode(QProcess::ForwardedChannels);
+        process->start(QCoreApplication::applicationFilePath(),
+                       QStringList(workerArguments) << "--worker-server" << serverName);
+        if (!process->waitForStarted()) {
+            qDebug() << "Could not start OCR worker:" << process->errorString();
+            std::cout << "ERROR: Could not start OCR worker " << slot << ": "
+                      << process->errorString().toStdString() << std::endl;
+            stop();
+            return false;
+        }
+
+        // Model loading can take a while; give up only if the worker exits
+        while (!socket) {
+            if (server->waitForNewConnection(1000)) {
+                socket = server->nextPendingConnection();
+            } else if (process->state() != QProcess::Running) {
+                std::cout << "ERROR: OCR worker " << slot << " exited during startup" << std::endl;
+                stop();
+                return false;
+            }
+        }
+
+        QByteArray line;
+        if (!readLine(line, 0) || line != "READY") {
+            std::cout << "ERROR: OCR worker " << slot << " failed to load its engine" << std::endl;
+            stop();
+            return false;
+        }
+
+        std::cout << "OCR worker " << slot << " ready (pid " << process->processId() << ")" << std::endl;
+        return true;
+    }
+
+    bool isRunning() const {
+        return process && socket && process->state() == QProcess::Running;
+    }
+
+    WorkerResult recognize(const QByteArray& imageBytes, const QString& label) {
+        WorkerResult result;
+        if (!isRunning()) {
+            result.crashed = true;
+            return result;
+        }
+        if (!ensureSharedMemory(imageBytes.size())) {
+            result.failed = true;
+            return result;
+        }
+
+        memcpy(memory->data(), imageBytes.constData(), imageBytes.size());
+
+        socket->write(QByteArray("IMAGE ") + memory->key().toUtf8() + " " + QByteArray::number(imageBytes.size())
+                      + " " + label.toUtf8().toBase64() + "\n");
+        socket->flush();
+
+        QByteArray line;
+        if (!readLine(line, hangTimeoutMs) || !line.startsWith("RESULT ")) {
+            std::cout << "OCR worker " << slot << " crashed or stopped responding on: "
+                      << label.toStdString() << std::endl;
+            stop();
+            result.crashed = true;
+            return result;
+        }
+
+        QList<QByteArray> parts = line.split(' ');
+        result.timedOut = parts.value(1) == "1";
+        result.text = QString::fromUtf8(QByteArray::fromBase64(parts.value(2)));
+        return result;
+    }
+
+    void stop() {
+        if (socket && socket->state() == QLocalSocket::ConnectedState) {
+            socket->write("QUIT\n");
+            socket->flush();
+            socket->waitForBytesWritten(1000);
+        }
+        socket = nullptr;
+
+        if (process) {
+            if (process->state() != QProcess::NotRunning && !process->waitForFinished(5000)) {
+                process->kill();
+                process->waitForFinished(5000);
+            }
+            process.reset();
+        }
+
+        // The server owns the accepted socket
+        server.reset();
+    }
+
+    // Number of times the worker was started, including the first start
+    int startCount() const {
+        return starts;
+    }
+
+    // Worker side: connects to serverName and recognizes images with recognize
+    // until the parent sends QUIT or goes away. Call after the engine is loaded.
+    static int serve(const QString& serverName,
+                     const std::function<QString(const QByteArray&, const QString&, bool&)>& recognize) {
+        QLocalSocket parent;
+        parent.connectToServer(serverName);
+        if (!parent.waitForConnected(10000)) {
+            std::cout << "ERROR: OCR worker could not connect to: " << serverName.toStdString() << std::endl;
+            return 1;
+        }
+
+        parent.write("READY\n");
+        parent.flush();
+
+        QSharedMemory imageMemory;
+        while (true) {
+            while (!parent.canReadLine()) {
+                if (!parent.waitForReadyRead(-1)) {
+                    return 0;
+                }
+            }
+
+            QList<QByteArray> parts = parent.readLine().trimmed().split(' ');
+            if (parts[0] == "QUIT") {
+                return 0;
+            }
+            if (parts[0] != "IMAGE" || parts.size() < 3) {
+                continue;
+            }
+
+            QString key = QString::fromUtf8(parts[1]);
+            int size = parts[2].toInt();
+            QString label = QString::fromUtf8(QByteArray::fromBase64(parts.value(3)));
+
+            // The parent only grows its segment under a new key
+            if (imageMemory.key() != key) {
+                if (imageMemory.isAttached()) {
+                    imageMemory.detach();
+                }
+                imageMemory.setKey(key);
+                imageMemory.attach(QSharedMemory::ReadOnly);
+            }
+
+            QString text;
+            bool timedOut = false;
+            if (imageMemory.isAttached() && size <= imageMemory.size()) {
+                QByteArray imageBytes(static_cast<const char*>(imageMemory.constData()), size);
+                text = recognize(imageBytes, label, timedOut);
+            } else {
+                std::cout << "ERROR: OCR worker could not read image memory: "
+                          << imageMemory.errorString().toStdString() << std::endl;
+            }
+
+            parent.write(QByteArray("RESULT ") + (timedOut ? "1" : "0") + " " + text.toUtf8().toBase64() + "\n");
+            parent.flush();
+            parent.waitForBytesWritten(-1);
+        }
+    }
+
+private:
+    // Reads one line from the worker; fails if the worker exits or timeoutMs passes (0 = no limit)
+    bool readLine(QByteArray& line, int timeoutMs) {
+        QElapsedTimer timer;
+        timer.start();
+        while (!socket->canReadLine()) {
+            if (socket->state() != QLocalSocket::ConnectedState || process->state() != QProcess::Running) {
+                return false;
+            }
+            if (timeoutMs > 0 && timer.elapsed() > timeoutMs) {
+                return false;
+            }
+            socket->waitForReadyRead(1000);
+        }
+        line = socket->readLine().trimmed();
+        return true;
+    }
+
+    bool ensureSharedMemory(int size) {
+        if (memory && memory->size() >= size) {
+            return true;
+        }
+
+        // Grow in whole megabytes under a new key so the worker re-attaches
+        int capacity = ((size + (1 << 20) - 1) >> 20 << 20) + (1 << 20);
+        memory.reset(new QSharedMemory(QString("tes_cpp_%1_%2_image_%3")
+                                           .arg(QCoreApplication::applicationPid()).arg(slot).arg(++memoryGeneration)));
+        if (!memory->create(capacity)) {
+            qDebug() << "Could not create shared image memory:" << memory->errorString();
+            std::cout << "ERROR: Could not create shared image memory: "
+                      << memory->errorString().toStdString() << std::endl;
+            memory.reset();
+            return false;
+        }
+        return true;
+    }
+
+    QStringList workerArguments;
+    int slot;
+    int hangTimeoutMs;
+    std::unique_ptr<QLocalServer> server;
+    std::unique_ptr<QProcess> process;
+    QLocalSocket* socket;
+    std::unique_ptr<QSharedMemory> memory;
+    int generation;
+    int memoryGeneration;
+    int starts;
+};
+
+#endif // WORKER_PROCESS_H